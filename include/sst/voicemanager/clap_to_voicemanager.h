@@ -0,0 +1,112 @@
+/*
+ * sst-voicemanager - a header only library providing synth
+ * voice management in response to midi and clap event streams
+ * with support for a variety of play, trigger, and midi nodes
+ *
+ * Copyright 2023-2024, various authors, as described in the GitHub
+ * transaction log.
+ *
+ * sst-voicemanager is released under the MIT license, available
+ * as LICENSE.md in the root of this repository.
+ *
+ * All source in sst-voicemanager available at
+ * https://github.com/surge-synthesizer/sst-voicemanager
+ */
+
+#ifndef INCLUDE_SST_VOICEMANAGER_CLAP_TO_VOICEMANAGER_H
+#define INCLUDE_SST_VOICEMANAGER_CLAP_TO_VOICEMANAGER_H
+
+#include <cstdint>
+
+#include "midi1_to_voicemanager.h"
+
+/*
+ * This header does not include CLAP itself. Include <clap/events.h> (or anything which
+ * declares the clap_event_* types and CLAP_EVENT_* constants) before including it.
+ */
+namespace sst::voicemanager
+{
+
+/**
+ * Route one CLAP event into the voice manager. Notes, note expressions, parameter
+ * modulation and MIDI 1 messages are handled; every other event, and any event outside
+ * the core event space, is ignored. A parameter modulation with a note id goes to the
+ * voice started with that id; one without but with a port, channel or key goes to the
+ * voices matching them; one with every field -1 is monophonic.
+ */
+template <typename Manager>
+void applyClapEvent(Manager &voiceManager, const clap_event_header_t *hdr)
+{
+    if (hdr->space_id != CLAP_CORE_EVENT_SPACE_ID)
+        return;
+
+    switch (hdr->type)
+    {
+    case CLAP_EVENT_NOTE_ON:
+    {
+        auto nevt = reinterpret_cast<const clap_event_note_t *>(hdr);
+        voiceManager.processNoteOnEvent(nevt->port_index, nevt->channel, nevt->key,
+                                        nevt->note_id, static_cast<float>(nevt->velocity), 0.f);
+        break;
+    }
+    case CLAP_EVENT_NOTE_OFF:
+    {
+        auto nevt = reinterpret_cast<const clap_event_note_t *>(hdr);
+        voiceManager.processNoteOffEvent(nevt->port_index, nevt->channel, nevt->key,
+                                         nevt->note_id, static_cast<float>(nevt->velocity));
+        break;
+    }
+    case CLAP_EVENT_NOTE_EXPRESSION:
+    {
+        auto nevt = reinterpret_cast<const clap_event_note_expression_t *>(hdr);
+        voiceManager.routeNoteExpression(nevt->port_index, nevt->channel, nevt->key,
+                                         nevt->note_id, nevt->expression_id, nevt->value);
+        break;
+    }
+    case CLAP_EVENT_PARAM_MOD:
+    {
+        auto pevt = reinterpret_cast<const clap_event_param_mod_t *>(hdr);
+        if (pevt->note_id >= 0)
+        {
+            voiceManager.routePolyphonicParameterModulation(pevt->port_index, pevt->channel,
+                                                            pevt->key, pevt->note_id,
+                                                            pevt->param_id, pevt->amount);
+        }
+        else if (pevt->port_index >= 0 || pevt->channel >= 0 || pevt->key >= 0)
+        {
+            voiceManager.routeKeyedPolyphonicParameterModulation(
+                pevt->port_index, pevt->channel, pevt->key, pevt->param_id, pevt->amount);
+        }
+        else
+        {
+            voiceManager.routeMonophonicParameterModulation(pevt->port_index, pevt->channel,
+                                                            pevt->key, pevt->param_id,
+                                                            pevt->amount);
+        }
+        break;
+    }
+    case CLAP_EVENT_MIDI:
+    {
+        auto mevt = reinterpret_cast<const clap_event_midi_t *>(hdr);
+        applyMidi1Message(voiceManager, mevt->port_index, mevt->data);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+/**
+ * Route every event of a CLAP input event list, in order. Events are read in place.
+ * A plugin which renders between events should call applyClapEvent itself as it walks
+ * the list.
+ */
+template <typename Manager, typename InputEvents>
+void applyClapInputEvents(Manager &voiceManager, const InputEvents *in)
+{
+    auto count = in->size(in);
+    for (uint32_t i = 0; i < count; ++i)
+        applyClapEvent(voiceManager, in->get(in, i));
+}
+} // namespace sst::voicemanager
+#endif // INCLUDE_SST_VOICEMANAGER_CLAP_TO_VOICEMANAGER_H
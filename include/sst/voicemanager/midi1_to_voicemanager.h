@@ -17,6 +17,8 @@
 #define INCLUDE_SST_VOICEMANAGER_MIDI1_TO_VOICEMANAGER_H
 
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
 
 namespace sst::voicemanager
 {
@@ -97,5 +99,76 @@ void applyMidi1Message(Manager &voiceManager, int16_t port_index, const uint8_t
     }
     }
 }
+
+/**
+ * The parser state applyMidi1Stream keeps between buffers: the running status, the data
+ * bytes of a message not yet complete, and whether we are inside a SysEx message.
+ */
+struct Midi1StreamState
+{
+    uint8_t status{0};
+    uint8_t data[2]{0, 0};
+    uint8_t dataCount{0};
+    bool inSysex{false};
+};
+
+/**
+ * Apply a raw MIDI 1 byte stream, such as one read from a hardware port. Running status is
+ * honored, real-time bytes may appear anywhere (even mid-message) and are ignored, and SysEx
+ * and system common messages are skipped. Each channel message is handed to
+ * applyMidi1Message as soon as its last data byte arrives. Pass the same state to
+ * successive calls to continue a message split across buffers.
+ */
+template <typename Manager>
+void applyMidi1Stream(Manager &voiceManager, int16_t port_index, const uint8_t *data, size_t len,
+                      Midi1StreamState &state)
+{
+    for (size_t i = 0; i < len; ++i)
+    {
+        auto b = data[i];
+        if (b >= 0xF8)
+            continue;
+
+        if (b & 0x80)
+        {
+            // Any status byte ends a SysEx, and only channel messages set running status
+            state.inSysex = (b == 0xF0);
+            state.status = (b < 0xF0 || b == 0xF1 || b == 0xF2 || b == 0xF3) ? b : 0;
+            state.dataCount = 0;
+            continue;
+        }
+
+        if (state.inSysex || state.status == 0)
+            continue;
+
+        state.data[state.dataCount++] = b;
+        auto kind = state.status & 0xF0;
+        auto needed = (kind == 0xC0 || kind == 0xD0 || state.status == 0xF1 ||
+                       state.status == 0xF3)
+                          ? 1
+                          : 2;
+        if (state.dataCount < needed)
+            continue;
+
+        state.dataCount = 0;
+        if (state.status >= 0xF0)
+        {
+            state.status = 0;
+            continue;
+        }
+        const uint8_t msg[3]{state.status, state.data[0], state.data[1]};
+        applyMidi1Message(voiceManager, port_index, msg);
+    }
+}
+
+/**
+ * Apply a self-contained MIDI 1 byte stream, starting with no running status.
+ */
+template <typename Manager>
+void applyMidi1Stream(Manager &voiceManager, int16_t port_index, const uint8_t *data, size_t len)
+{
+    Midi1StreamState state;
+    applyMidi1Stream(voiceManager, port_index, data, len, state);
+}
 } // namespace sst::voicemanager
 #endif // CONDUIT_MIDI1_TO_VOICEMANAGER_H
@@ -0,0 +1,154 @@
+/*
+ * sst-voicemanager - a header only library providing synth
+ * voice management in response to midi and clap event streams
+ * with support for a variety of play, trigger, and midi nodes
+ *
+ * Copyright 2023-2024, various authors, as described in the GitHub
+ * transaction log.
+ *
+ * sst-voicemanager is released under the MIT license, available
+ * as LICENSE.md in the root of this repository.
+ *
+ * All source in sst-voicemanager available at
+ * https://github.com/surge-synthesizer/sst-voicemanager
+ */
+
+#ifndef INCLUDE_SST_VOICEMANAGER_UMP_TO_VOICEMANAGER_H
+#define INCLUDE_SST_VOICEMANAGER_UMP_TO_VOICEMANAGER_H
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <span>
+
+#include "midi1_to_voicemanager.h"
+
+/*
+ * Feed a buffer of MIDI 2.0 Universal MIDI Packets to the voice manager. Each packet's UMP
+ * group is used as the port. MIDI 2 channel voice messages keep their full resolution where
+ * the voice manager API can carry it; MIDI 1 channel voice packets go through
+ * applyMidi1Message; everything else (utility, system, data, stream and per-note management
+ * packets, program change and (N)RPN) is skipped.
+ */
+namespace sst::voicemanager
+{
+
+/**
+ * The note expression ids the per-note messages arrive on. Registered per-note controller n
+ * is expression umpRegisteredPerNoteControllerBase + n and assignable per-note controller n
+ * is umpAssignablePerNoteControllerBase + n, each with a value in [0, 1]. Per-note pitch
+ * bend is umpPerNotePitchBendExpression with a value in [-1, 1]. All of these sit above the
+ * CLAP note expression ids, which clap_to_voicemanager.h passes through unchanged, so a
+ * responder fed by both adapters can tell the sources apart.
+ */
+static constexpr int32_t umpRegisteredPerNoteControllerBase{1024};
+static constexpr int32_t umpAssignablePerNoteControllerBase{1280};
+static constexpr int32_t umpPerNotePitchBendExpression{1536};
+
+namespace detail
+{
+// Packet length in words, by message type (the top nibble of the first word)
+static constexpr std::array<uint8_t, 16> umpWordCount{1, 1, 1, 2, 2, 4, 1, 1,
+                                                      2, 2, 2, 3, 3, 4, 4, 4};
+
+inline double umpUnipolar(uint32_t v) { return v / 4294967295.0; }
+inline double umpBipolar(uint32_t v)
+{
+    return (static_cast<double>(v) - 2147483648.0) / 2147483648.0;
+}
+
+template <typename Manager>
+void applyUMPMidi2ChannelVoice(Manager &voiceManager, uint32_t w0, uint32_t w1)
+{
+    auto port = static_cast<int16_t>((w0 >> 24) & 0x0F);
+    auto status = (w0 >> 20) & 0x0F;
+    auto chan = static_cast<int16_t>((w0 >> 16) & 0x0F);
+    auto key = static_cast<int16_t>((w0 >> 8) & 0x7F);
+    auto index = static_cast<int32_t>(w0 & 0xFF);
+
+    switch (status)
+    {
+    case 0x0: // Registered per-note controller
+        voiceManager.routeNoteExpression(port, chan, key, -1,
+                                         umpRegisteredPerNoteControllerBase + index,
+                                         umpUnipolar(w1));
+        break;
+    case 0x1: // Assignable per-note controller
+        voiceManager.routeNoteExpression(port, chan, key, -1,
+                                         umpAssignablePerNoteControllerBase + index,
+                                         umpUnipolar(w1));
+        break;
+    case 0x6: // Per-note pitch bend
+        voiceManager.routeNoteExpression(port, chan, key, -1, umpPerNotePitchBendExpression,
+                                         umpBipolar(w1));
+        break;
+    case 0x8:
+        voiceManager.processNoteOffEvent(port, chan, key, -1, (w1 >> 16) / 65535.f);
+        break;
+    case 0x9:
+    {
+        // Unlike MIDI 1, velocity zero is still a note on. Attribute type 3 carries the
+        // note's pitch as 7.9 fixed point semitones, which becomes the retune.
+        float retune{0.f};
+        if (index == 3)
+            retune = (w1 & 0xFFFF) / 512.f - key;
+        voiceManager.processNoteOnEvent(port, chan, key, -1, (w1 >> 16) / 65535.f, retune);
+        break;
+    }
+    case 0xA:
+        voiceManager.routePolyphonicAftertouch(port, chan, key, static_cast<int8_t>(w1 >> 25));
+        break;
+    case 0xB:
+    {
+        // Down to 7 bits so the pedal and channel mode controllers behave as in MIDI 1
+        const uint8_t d[3]{static_cast<uint8_t>(0xB0 | chan), static_cast<uint8_t>(key),
+                           static_cast<uint8_t>(w1 >> 25)};
+        applyMidi1Message(voiceManager, port, d);
+        break;
+    }
+    case 0xD:
+        voiceManager.routeChannelPressure(port, chan, static_cast<int8_t>(w1 >> 25));
+        break;
+    case 0xE:
+        voiceManager.routeMIDIPitchBend(port, chan, static_cast<int16_t>(w1 >> 18));
+        break;
+    default:
+        break;
+    }
+}
+} // namespace detail
+
+/**
+ * Apply the whole packets at the front of words, in order, and return the number of words
+ * consumed. A packet cut off at the end of the buffer is left unconsumed, so a caller reading
+ * from a stream can carry the tail over to the next call.
+ */
+template <typename Manager>
+size_t applyUMPWords(Manager &voiceManager, std::span<const uint32_t> words)
+{
+    size_t pos{0};
+    while (pos < words.size())
+    {
+        auto w0 = words[pos];
+        auto mt = w0 >> 28;
+        auto len = detail::umpWordCount[mt];
+        if (pos + len > words.size())
+            break;
+
+        if (mt == 0x4)
+        {
+            detail::applyUMPMidi2ChannelVoice(voiceManager, w0, words[pos + 1]);
+        }
+        else if (mt == 0x2)
+        {
+            const uint8_t d[3]{static_cast<uint8_t>(w0 >> 16),
+                               static_cast<uint8_t>((w0 >> 8) & 0x7F),
+                               static_cast<uint8_t>(w0 & 0x7F)};
+            applyMidi1Message(voiceManager, static_cast<int16_t>((w0 >> 24) & 0x0F), d);
+        }
+        pos += len;
+    }
+    return pos;
+}
+} // namespace sst::voicemanager
+#endif // INCLUDE_SST_VOICEMANAGER_UMP_TO_VOICEMANAGER_H
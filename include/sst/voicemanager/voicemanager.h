@@ -23,6 +23,8 @@
 #include <limits>
 #include <algorithm>
 #include <functional>
+#include <concepts>
+#include <span>
 
 /**
  * \mainpage SST Voice Manager
@@ -42,6 +44,80 @@ namespace sst::voicemanager
 template <typename Cfg>
 concept HasVoiceContinuationData = requires { typename Cfg::continuationData_t; };
 
+/**
+ * HasMaxHeldKeyStateCount is a concept which checks if the Cfg type sets a
+ * maxHeldKeyStateCount, the number of held (port, channel, key, group) records the voice
+ * manager preallocates to track keys down in mono groups. If absent a default is used.
+ */
+template <typename Cfg>
+concept HasMaxHeldKeyStateCount = requires {
+    { Cfg::maxHeldKeyStateCount } -> std::convertible_to<size_t>;
+};
+
+/**
+ * HasPreferRecentlyFreedVoiceSlots is a concept which checks if the Cfg type sets a
+ * preferRecentlyFreedVoiceSlots flag. When true a new voice reuses the most recently freed
+ * slot (whose state is likely still in cache) rather than the lowest free slot.
+ */
+template <typename Cfg>
+concept HasPreferRecentlyFreedVoiceSlots = requires {
+    { Cfg::preferRecentlyFreedVoiceSlots } -> std::convertible_to<bool>;
+};
+
+/**
+ * HasNoteIdStackSize is a concept which checks if the Cfg type sets a noteIdStackSize, the
+ * number of note ids each voice keeps inline as it is moved from note to note in legato and
+ * piano modes (so a note off by any of those ids still finds it). If absent a small default
+ * is used.
+ */
+template <typename Cfg>
+concept HasNoteIdStackSize = requires {
+    { Cfg::noteIdStackSize } -> std::convertible_to<size_t>;
+};
+
+/**
+ * HasNoteIdOverflowCount is a concept which checks if the Cfg type sets a
+ * noteIdOverflowCount, the number of older note ids shared across all voices once their
+ * inline stacks are full (the rare deep legato case). When that too is full a voice
+ * forgets its oldest id. If absent a default is used.
+ */
+template <typename Cfg>
+concept HasNoteIdOverflowCount = requires {
+    { Cfg::noteIdOverflowCount } -> std::convertible_to<size_t>;
+};
+
+/**
+ * HasMaxCoalescedControllerCount is a concept which checks if the Cfg type sets a
+ * maxCoalescedControllerCount, the number of distinct (controller, port, channel, key)
+ * updates held back between flushes when coalesceControllers is on. Past it, an update for a
+ * new controller is delivered at once. If absent a default is used.
+ */
+template <typename Cfg>
+concept HasMaxCoalescedControllerCount = requires {
+    { Cfg::maxCoalescedControllerCount } -> std::convertible_to<size_t>;
+};
+
+/**
+ * HasMaxPolyphonyGroupCount is a concept which checks if the Cfg type sets a
+ * maxPolyphonyGroupCount, the number of distinct polyphony groups the voice manager
+ * preallocates room for (the default group 0 among them). Past it, guaranteeGroup and the
+ * group setters do nothing for a new group. If absent a default is used.
+ */
+template <typename Cfg>
+concept HasMaxPolyphonyGroupCount = requires {
+    { Cfg::maxPolyphonyGroupCount } -> std::convertible_to<size_t>;
+};
+
+/**
+ * HasCoalescedControllerOffset is a concept which checks if a Responder or MonoResponder
+ * defines setCoalescedControllerOffset(uint32_t). The controller calls have no place for a
+ * sample offset, so a responder which wants to position flushed controllers in the block
+ * defines this, and hears the flush's offset just before each value the flush delivers.
+ */
+template <typename R>
+concept HasCoalescedControllerOffset =
+    requires(R &r, uint32_t sampleOffset) { r.setCoalescedControllerOffset(sampleOffset); };
+
 /**
  * VoiceInitBufferEntry is the object which the responder needs to populate
  * in the voice initiation creation lifecycle.
@@ -69,6 +145,54 @@ template <typename Cfg> struct ContinuationDataType<Cfg, true>
 {
     using type = typename Cfg::continuationData_t;
 };
+
+template <typename Cfg> constexpr size_t maxHeldKeyStateCount()
+{
+    if constexpr (HasMaxHeldKeyStateCount<Cfg>)
+        return Cfg::maxHeldKeyStateCount;
+    else
+        return 256;
+}
+
+template <typename Cfg> constexpr size_t noteIdStackSize()
+{
+    if constexpr (HasNoteIdStackSize<Cfg>)
+        return Cfg::noteIdStackSize;
+    else
+        return 8;
+}
+
+template <typename Cfg> constexpr size_t noteIdOverflowCount()
+{
+    if constexpr (HasNoteIdOverflowCount<Cfg>)
+        return Cfg::noteIdOverflowCount;
+    else
+        return 256;
+}
+
+template <typename Cfg> constexpr size_t maxCoalescedControllerCount()
+{
+    if constexpr (HasMaxCoalescedControllerCount<Cfg>)
+        return Cfg::maxCoalescedControllerCount;
+    else
+        return 256;
+}
+
+template <typename Cfg> constexpr size_t maxPolyphonyGroupCount()
+{
+    if constexpr (HasMaxPolyphonyGroupCount<Cfg>)
+        return Cfg::maxPolyphonyGroupCount;
+    else
+        return 256;
+}
+
+template <typename Cfg> constexpr bool preferRecentlyFreedVoiceSlots()
+{
+    if constexpr (HasPreferRecentlyFreedVoiceSlots<Cfg>)
+        return Cfg::preferRecentlyFreedVoiceSlots;
+    else
+        return false;
+}
 } // namespace detail
 
 /**
@@ -105,7 +229,12 @@ template <typename Cfg> struct VoiceInitInstructionsEntry
  */
 template <typename Cfg> struct VoiceBeginBufferEntry
 {
-    uint64_t polyphonyGroup; ///< The polyphony group in which this voice participates
+    /**
+     * The polyphony group in which this voice participates. It should have been guaranteed
+     * (or configured through a group setter); a group that was not plays in the default
+     * group 0, as note on never allocates a new group.
+     */
+    uint64_t polyphonyGroup;
 
     /**
      * buffer_t is the typedef for the working group array you will receive
@@ -114,6 +243,94 @@ template <typename Cfg> struct VoiceBeginBufferEntry
     using buffer_t = std::array<VoiceBeginBufferEntry<Cfg>, Cfg::maxVoiceCount>;
 };
 
+/**
+ * VoiceEvent is one timestamped event in a block handed to VoiceManager::processEvents. Each
+ * type maps onto one of the single-event calls and uses the fields that call takes; the
+ * static constructors fill in the right ones.
+ */
+struct VoiceEvent
+{
+    enum struct Type : uint8_t
+    {
+        NOTE_ON,                  ///< processNoteOnEvent(port, channel, key, noteId, value, retune)
+        NOTE_OFF,                 ///< processNoteOffEvent(port, channel, key, noteId, value)
+        SUSTAIN_PEDAL,            ///< updateSustainPedal(port, channel, data)
+        MIDI_PITCH_BEND,          ///< routeMIDIPitchBend(port, channel, data)
+        MIDI1_CC,                 ///< routeMIDI1CC(port, channel, index, data)
+        POLYPHONIC_AFTERTOUCH,    ///< routePolyphonicAftertouch(port, channel, key, data)
+        CHANNEL_PRESSURE,         ///< routeChannelPressure(port, channel, data)
+        NOTE_EXPRESSION,          ///< routeNoteExpression(port, channel, key, noteId, index, value)
+        POLYPHONIC_PARAMETER_MOD, ///< routePolyphonicParameterModulation(..., noteId as voice id)
+        KEYED_PARAMETER_MOD,      ///< routeKeyedPolyphonicParameterModulation(..., index, value)
+        MONOPHONIC_PARAMETER_MOD  ///< routeMonophonicParameterModulation(..., index, value)
+    } type{Type::NOTE_ON};
+
+    uint32_t sampleOffset{0}; ///< Position in the block; a block's events must be sorted by it
+    int16_t port{0}, channel{0}, key{-1};
+    int32_t noteId{-1}; ///< The note id, or the voice id for POLYPHONIC_PARAMETER_MOD
+    uint32_t index{0};  ///< CC number, note expression id or parameter id
+    int32_t data{0};    ///< CC value, pedal level, 14 bit pitch bend, aftertouch or pressure
+    double value{0};    ///< Velocity, note expression value or modulation value
+    float retune{0};
+
+    static VoiceEvent noteOn(uint32_t at, int16_t port, int16_t channel, int16_t key,
+                             int32_t noteId, float velocity, float retune = 0.f)
+    {
+        return {Type::NOTE_ON, at, port, channel, key, noteId, 0, 0, velocity, retune};
+    }
+    static VoiceEvent noteOff(uint32_t at, int16_t port, int16_t channel, int16_t key,
+                              int32_t noteId, float velocity)
+    {
+        return {Type::NOTE_OFF, at, port, channel, key, noteId, 0, 0, velocity};
+    }
+    static VoiceEvent sustainPedal(uint32_t at, int16_t port, int16_t channel, int8_t level)
+    {
+        return {Type::SUSTAIN_PEDAL, at, port, channel, -1, -1, 0, level};
+    }
+    static VoiceEvent pitchBend(uint32_t at, int16_t port, int16_t channel, int16_t pb14bit)
+    {
+        return {Type::MIDI_PITCH_BEND, at, port, channel, -1, -1, 0, pb14bit};
+    }
+    static VoiceEvent midi1CC(uint32_t at, int16_t port, int16_t channel, int8_t cc, int8_t val)
+    {
+        return {Type::MIDI1_CC, at, port, channel, -1, -1, static_cast<uint32_t>(cc), val};
+    }
+    static VoiceEvent polyphonicAftertouch(uint32_t at, int16_t port, int16_t channel,
+                                           int16_t key, int8_t pat)
+    {
+        return {Type::POLYPHONIC_AFTERTOUCH, at, port, channel, key, -1, 0, pat};
+    }
+    static VoiceEvent channelPressure(uint32_t at, int16_t port, int16_t channel, int8_t pat)
+    {
+        return {Type::CHANNEL_PRESSURE, at, port, channel, -1, -1, 0, pat};
+    }
+    static VoiceEvent noteExpression(uint32_t at, int16_t port, int16_t channel, int16_t key,
+                                     int32_t noteId, int32_t expression, double value)
+    {
+        return {Type::NOTE_EXPRESSION, at, port, channel, key, noteId,
+                static_cast<uint32_t>(expression), 0, value};
+    }
+    static VoiceEvent polyphonicParameterModulation(uint32_t at, int16_t port, int16_t channel,
+                                                    int16_t key, int32_t voiceId,
+                                                    uint32_t parameter, double value)
+    {
+        return {Type::POLYPHONIC_PARAMETER_MOD, at, port, channel, key, voiceId, parameter, 0,
+                value};
+    }
+    static VoiceEvent keyedPolyphonicParameterModulation(uint32_t at, int16_t port,
+                                                         int16_t channel, int16_t key,
+                                                         uint32_t parameter, double value)
+    {
+        return {Type::KEYED_PARAMETER_MOD, at, port, channel, key, -1, parameter, 0, value};
+    }
+    static VoiceEvent monophonicParameterModulation(uint32_t at, int16_t port, int16_t channel,
+                                                    int16_t key, uint32_t parameter,
+                                                    double value)
+    {
+        return {Type::MONOPHONIC_PARAMETER_MOD, at, port, channel, key, -1, parameter, 0, value};
+    }
+};
+
 /**
  * VoiceManager is the main class used for voice management, and the sole public API.
  * The voice manager has the following features
@@ -210,6 +427,16 @@ template <typename Cfg, typename Responder, typename MonoResponder> struct Voice
     int8_t mpeGlobalChannel{0};
     static constexpr int8_t mpeTimbreCC{74};
 
+    /**
+     * When true, pitch bend, channel pressure, MIDI 1 CC and polyphonic aftertouch are not
+     * delivered as they arrive. Only the latest value per (port, channel) (and key or CC) is
+     * kept, and it goes out on flushCoalescedControllers, which the synth should call before
+     * it renders. A note on or off, or a sustain pedal change, first flushes what is held for
+     * its channel, so notes see controllers exactly as they would uncoalesced; allNotesOff
+     * and the allSoundsOff calls flush everything first. Flush before turning this off.
+     */
+    bool coalesceControllers{false};
+
     Responder &responder;
     MonoResponder &monoResponder;
     VoiceManager(Responder &r, MonoResponder &m);
@@ -236,9 +463,39 @@ template <typename Cfg, typename Responder, typename MonoResponder> struct Voice
 
     void routePolyphonicParameterModulation(int16_t port, int16_t channel, int16_t key,
                                             int32_t voiceid, uint32_t parameter, double value);
+    /**
+     * Polyphonic modulation addressed by port, channel and key rather than voice id, each -1
+     * a wildcard, as with CLAP's key-addressed parameter modulation.
+     */
+    void routeKeyedPolyphonicParameterModulation(int16_t port, int16_t channel, int16_t key,
+                                                 uint32_t parameter, double value);
     void routeMonophonicParameterModulation(int16_t port, int16_t channel, int16_t key,
                                             uint32_t parameter, double value);
 
+    /**
+     * Dispatch timestamp-sorted events to their single-event calls, stopping at the first
+     * whose sampleOffset is not below untilSample. Returns the count dispatched, so a host
+     * which renders between events can hand back the tail at each split point.
+     *
+     * Within a block, pitch bend, channel pressure, MIDI 1 CC and polyphonic aftertouch are
+     * coalesced per offset whether or not coalesceControllers is on: the latest value per
+     * controller goes out once, when the block moves past that offset or ends, carrying it
+     * to responders meeting HasCoalescedControllerOffset. A note, pedal or all-off event
+     * flushes first as it does outside a block, but at its own offset. Nothing is left held
+     * on return.
+     */
+    size_t processEvents(std::span<const VoiceEvent> events,
+                         uint32_t untilSample = std::numeric_limits<uint32_t>::max());
+
+    /**
+     * Deliver the controller values held back under coalesceControllers, as of sampleOffset
+     * in the block. The offset reaches only responders meeting HasCoalescedControllerOffset.
+     * Values flushed ahead of a note, pedal or all-off event go out at that event's
+     * sampleOffset when it comes through processEvents, and at 0 from the single-event
+     * calls, which carry no timing.
+     */
+    void flushCoalescedControllers(uint32_t sampleOffset = 0);
+
     [[nodiscard]] size_t getVoiceCount() const;
     [[nodiscard]] size_t getGatedVoiceCount() const;
     void allNotesOff();
@@ -251,6 +508,11 @@ template <typename Cfg, typename Responder, typename MonoResponder> struct Voice
      */
     static constexpr uint64_t noPolyphonyGroupParent{std::numeric_limits<uint64_t>::max()};
 
+    /**
+     * Make room for a group with every per-group default. The group setters do this too.
+     * Only maxPolyphonyGroupCount groups fit; past that a new group is ignored here and by
+     * the setters, and its voices play in the default group 0.
+     */
     void guaranteeGroup(uint64_t groupId);
     void setPolyphonyGroupVoiceLimit(uint64_t groupId, int32_t limit);
     [[nodiscard]] int32_t getPolyphonyGroupVoiceLimit(uint64_t groupId) const;
@@ -259,13 +521,17 @@ template <typename Cfg, typename Responder, typename MonoResponder> struct Voice
      * Make childGroup count its voices against parentGroup (and every ancestor above it),
      * forming a hierarchy. A voice still belongs to exactly one group but is budgeted by
      * the whole ancestor chain. Pass noPolyphonyGroupParent to detach. Returns false
-     * (no-op) if it would create a cycle, or if the parent is MONO (only leaf groups may
-     * be MONO).
+     * (no-op) if it would create a cycle, if the parent is MONO (only leaf groups may be
+     * MONO), or if either group does not fit in the group table. It may be called with
+     * notes sounding: the subtree's voice counts move along the two ancestor chains and
+     * its place in the group order is moved, costing the chains' depth plus the groups
+     * between its old and new place, and it never allocates.
      */
     bool setPolyphonyGroupParent(uint64_t childGroup, uint64_t parentGroup);
     /**
      * Set a group's play mode. Returns false (leaving the group unchanged) if a MONO mode
-     * is requested for a group that has children, since only leaf groups may be MONO.
+     * is requested for a group that has children, since only leaf groups may be MONO, or if
+     * the group does not fit in the group table.
      */
     bool setPlaymode(uint64_t groupId, PlayMode pm,
                      uint64_t features = static_cast<uint64_t>(MonoPlayModeFeatures::NONE));
@@ -0,0 +1,443 @@
+/*
+ * sst-voicemanager - a header only library providing synth
+ * voice management in response to midi and clap event streams
+ * with support for a variety of play, trigger, and midi nodes
+ *
+ * Copyright 2023-2024, various authors, as described in the GitHub
+ * transaction log.
+ *
+ * sst-voicemanager is released under the MIT license, available
+ * as LICENSE.md in the root of this repository.
+ *
+ * All source in sst-voicemanager available at
+ * https://github.com/surge-synthesizer/sst-voicemanager
+ */
+
+#ifndef INCLUDE_SST_VOICEMANAGER_VOICEMANAGER_CONTAINERS_H
+#define INCLUDE_SST_VOICEMANAGER_VOICEMANAGER_CONTAINERS_H
+
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * Fixed capacity containers used by the voice manager internals. Everything here is sized
+ * at compile time and never touches the heap, so it is safe to use from the audio thread.
+ */
+namespace sst::voicemanager::detail
+{
+constexpr size_t nextPowerOfTwo(size_t v)
+{
+    size_t res{1};
+    while (res < v)
+        res <<= 1;
+    return res;
+}
+
+inline uint64_t mixHash(uint64_t x)
+{
+    // splitmix64 finalizer; cheap and good enough to spread packed keys over a small table
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+/**
+ * FixedVector is an inline vector with a compile time capacity. Pushing past capacity is a
+ * programming error; callers size it from a bound they know (typically Cfg::maxVoiceCount).
+ */
+template <typename T, size_t Capacity> struct FixedVector
+{
+    static_assert(Capacity > 0);
+
+    [[nodiscard]] size_t size() const { return count; }
+    [[nodiscard]] bool empty() const { return count == 0; }
+    static constexpr size_t capacity() { return Capacity; }
+    void clear() { count = 0; }
+
+    void push_back(const T &v)
+    {
+        assert(count < Capacity);
+        if (count < Capacity)
+            storage[count++] = v;
+    }
+
+    void pop_back()
+    {
+        assert(count > 0);
+        --count;
+    }
+    T &back() { return storage[count - 1]; }
+    const T &back() const { return storage[count - 1]; }
+
+    T &operator[](size_t i) { return storage[i]; }
+    const T &operator[](size_t i) const { return storage[i]; }
+
+    T *begin() { return storage.data(); }
+    T *end() { return storage.data() + count; }
+    const T *begin() const { return storage.data(); }
+    const T *end() const { return storage.data() + count; }
+
+    [[nodiscard]] bool contains(const T &v) const
+    {
+        for (size_t i = 0; i < count; ++i)
+            if (storage[i] == v)
+                return true;
+        return false;
+    }
+
+    /**
+     * push_back v unless it is already present; a small set in insertion order
+     */
+    void insertUnique(const T &v)
+    {
+        if (!contains(v))
+            push_back(v);
+    }
+
+  private:
+    std::array<T, Capacity> storage{};
+    size_t count{0};
+};
+
+/**
+ * FixedLinearMap is a small map with linear lookup, iterating in insertion order. It suits
+ * the handful of distinct groups touched by a single event, where a scan of a few entries
+ * beats hashing and nothing may allocate.
+ */
+template <typename Key, typename Value, size_t Capacity> struct FixedLinearMap
+{
+    struct Entry
+    {
+        Key key{};
+        Value value{};
+    };
+
+    [[nodiscard]] size_t size() const { return entries.size(); }
+    [[nodiscard]] bool empty() const { return entries.empty(); }
+    void clear() { entries.clear(); }
+
+    Value *find(const Key &k)
+    {
+        for (auto &e : entries)
+            if (e.key == k)
+                return &e.value;
+        return nullptr;
+    }
+
+    /**
+     * Like std::map::operator[], value-initializing an absent key.
+     */
+    Value &operator[](const Key &k)
+    {
+        if (auto *v = find(k))
+            return *v;
+        entries.push_back({k, Value{}});
+        return entries[entries.size() - 1].value;
+    }
+
+    Entry *begin() { return entries.begin(); }
+    Entry *end() { return entries.end(); }
+    const Entry *begin() const { return entries.begin(); }
+    const Entry *end() const { return entries.end(); }
+
+  private:
+    FixedVector<Entry, Capacity> entries;
+};
+
+/**
+ * FixedPool hands out stable int32_t indices into a fixed array of T, recycling released
+ * slots through a free list. Unlike FixedDenseMap entries never move, so indices can be
+ * threaded through other structures as intrusive links.
+ */
+template <typename T, size_t Capacity> struct FixedPool
+{
+    static_assert(Capacity > 0);
+
+    FixedPool() { clear(); }
+
+    void clear()
+    {
+        for (size_t i = 0; i < Capacity; ++i)
+            nextFree[i] = (i + 1 < Capacity) ? static_cast<int32_t>(i + 1) : -1;
+        freeHead = 0;
+        count = 0;
+    }
+
+    [[nodiscard]] bool full() const { return freeHead < 0; }
+    [[nodiscard]] size_t size() const { return count; }
+
+    /**
+     * Returns the index of a value-initialized slot, or -1 if the pool is exhausted.
+     */
+    int32_t allocate()
+    {
+        if (freeHead < 0)
+            return -1;
+        auto res = freeHead;
+        freeHead = nextFree[res];
+        storage[res] = T{};
+        ++count;
+        return res;
+    }
+
+    void release(int32_t idx)
+    {
+        assert(idx >= 0 && idx < static_cast<int32_t>(Capacity));
+        nextFree[idx] = freeHead;
+        freeHead = idx;
+        --count;
+    }
+
+    T &operator[](int32_t i) { return storage[i]; }
+    const T &operator[](int32_t i) const { return storage[i]; }
+
+  private:
+    std::array<T, Capacity> storage{};
+    std::array<int32_t, Capacity> nextFree{};
+    int32_t freeHead{-1};
+    size_t count{0};
+};
+
+/**
+ * SlotBitmap tracks which of Capacity slots are free with one bit per slot and a summary
+ * word with one bit per non-empty 64 slot word, so the lowest free slot is found with a
+ * couple of count-trailing-zeros rather than a scan. Everything starts free.
+ */
+template <size_t Capacity> struct SlotBitmap
+{
+    static_assert(Capacity > 0);
+    static constexpr size_t wordCount{(Capacity + 63) / 64};
+    static constexpr size_t summaryCount{(wordCount + 63) / 64};
+
+    SlotBitmap() { setAllFree(); }
+
+    void setAllFree()
+    {
+        words.fill(0);
+        summary.fill(0);
+        for (size_t i = 0; i < Capacity; ++i)
+            markFree(static_cast<int32_t>(i));
+    }
+
+    [[nodiscard]] bool isFree(int32_t i) const { return words[i >> 6] & (1ULL << (i & 63)); }
+
+    /**
+     * The free bits of slots [64 * w, 64 * w + 63], for masking whole words of slots at once.
+     */
+    [[nodiscard]] uint64_t freeWord(size_t w) const { return words[w]; }
+
+    void markFree(int32_t i)
+    {
+        assert(i >= 0 && i < static_cast<int32_t>(Capacity));
+        auto w = static_cast<size_t>(i) >> 6;
+        words[w] |= 1ULL << (i & 63);
+        summary[w >> 6] |= 1ULL << (w & 63);
+    }
+
+    void markUsed(int32_t i)
+    {
+        assert(i >= 0 && i < static_cast<int32_t>(Capacity));
+        auto w = static_cast<size_t>(i) >> 6;
+        words[w] &= ~(1ULL << (i & 63));
+        if (words[w] == 0)
+            summary[w >> 6] &= ~(1ULL << (w & 63));
+    }
+
+    /**
+     * The lowest free slot, or -1 if every slot is in use.
+     */
+    [[nodiscard]] int32_t findFirstFree() const
+    {
+        for (size_t s = 0; s < summaryCount; ++s)
+        {
+            if (summary[s] == 0)
+                continue;
+            auto w = (s << 6) + static_cast<size_t>(std::countr_zero(summary[s]));
+            return static_cast<int32_t>((w << 6) + std::countr_zero(words[w]));
+        }
+        return -1;
+    }
+
+  private:
+    std::array<uint64_t, wordCount> words{};
+    std::array<uint64_t, summaryCount> summary{};
+};
+
+/**
+ * FixedDenseMap is a fixed capacity map. Entries live densely packed in a slab (so iteration
+ * costs the number of entries held, not the capacity) and are found through an open-addressed,
+ * linear-probed index with backward-shift deletion (so there are no tombstones to clean up).
+ * Erasure swaps the last entry into the hole, so iteration order is not stable across erases.
+ *
+ * @tparam Key an equality comparable key
+ * @tparam Value the mapped value
+ * @tparam Capacity the maximum number of entries; insertion fails once it is reached
+ * @tparam Hash a functor returning a uint64_t for a Key
+ */
+template <typename Key, typename Value, size_t Capacity, typename Hash> struct FixedDenseMap
+{
+    static_assert(Capacity > 0);
+    static constexpr size_t indexSize{nextPowerOfTwo(Capacity * 2)};
+    static constexpr size_t indexMask{indexSize - 1};
+
+    FixedDenseMap() { clear(); }
+
+    [[nodiscard]] size_t size() const { return count; }
+    [[nodiscard]] bool empty() const { return count == 0; }
+    static constexpr size_t capacity() { return Capacity; }
+
+    void clear()
+    {
+        index.fill(-1);
+        count = 0;
+    }
+
+    Value *find(const Key &k)
+    {
+        auto pos = findIndexSlot(k);
+        return pos < 0 ? nullptr : &values[index[pos]];
+    }
+    const Value *find(const Key &k) const
+    {
+        auto pos = findIndexSlot(k);
+        return pos < 0 ? nullptr : &values[index[pos]];
+    }
+
+    /**
+     * Insert or overwrite the value at k. Returns a pointer to the stored value, or nullptr
+     * if k is absent and the map is already at capacity.
+     */
+    Value *insertOrAssign(const Key &k, const Value &v)
+    {
+        auto pos = homeSlot(k);
+        while (index[pos] >= 0)
+        {
+            if (keys[index[pos]] == k)
+            {
+                values[index[pos]] = v;
+                return &values[index[pos]];
+            }
+            pos = (pos + 1) & indexMask;
+        }
+        if (count == Capacity)
+            return nullptr;
+
+        auto d = static_cast<int32_t>(count++);
+        keys[d] = k;
+        values[d] = v;
+        index[pos] = d;
+        return &values[d];
+    }
+
+    bool erase(const Key &k)
+    {
+        auto pos = findIndexSlot(k);
+        if (pos < 0)
+            return false;
+        eraseAtIndexSlot(static_cast<size_t>(pos));
+        return true;
+    }
+
+    /**
+     * Call f(key, value&) for every entry.
+     */
+    template <typename F> void forEach(F &&f)
+    {
+        for (size_t i = 0; i < count; ++i)
+            f(static_cast<const Key &>(keys[i]), values[i]);
+    }
+    template <typename F> void forEach(F &&f) const
+    {
+        for (size_t i = 0; i < count; ++i)
+            f(keys[i], values[i]);
+    }
+
+    /**
+     * Erase every entry for which pred(key, value) is true. Returns the number erased.
+     */
+    template <typename P> size_t eraseIf(P &&pred)
+    {
+        size_t erased{0};
+        size_t i{0};
+        while (i < count)
+        {
+            if (pred(static_cast<const Key &>(keys[i]), static_cast<const Value &>(values[i])))
+            {
+                // the swap-remove moves the last entry into i, so look at i again
+                eraseAtIndexSlot(static_cast<size_t>(findIndexSlot(keys[i])));
+                ++erased;
+            }
+            else
+            {
+                ++i;
+            }
+        }
+        return erased;
+    }
+
+  private:
+    std::array<Key, Capacity> keys{};
+    std::array<Value, Capacity> values{};
+    std::array<int32_t, indexSize> index{};
+    size_t count{0};
+
+    static size_t homeSlot(const Key &k) { return static_cast<size_t>(Hash{}(k)) & indexMask; }
+
+    int32_t findIndexSlot(const Key &k) const
+    {
+        auto pos = homeSlot(k);
+        while (index[pos] >= 0)
+        {
+            if (keys[index[pos]] == k)
+                return static_cast<int32_t>(pos);
+            pos = (pos + 1) & indexMask;
+        }
+        return -1;
+    }
+
+    void eraseAtIndexSlot(size_t pos)
+    {
+        auto d = index[pos];
+
+        // Backward-shift deletion: pull later members of the probe run into the hole when
+        // their home slot does not sit cyclically in (hole, candidate].
+        auto hole = pos;
+        auto j = pos;
+        while (true)
+        {
+            j = (j + 1) & indexMask;
+            if (index[j] < 0)
+                break;
+            auto home = homeSlot(keys[index[j]]);
+            auto distHome = (j - home) & indexMask;
+            auto distHole = (j - hole) & indexMask;
+            if (distHome >= distHole)
+            {
+                index[hole] = index[j];
+                hole = j;
+            }
+        }
+        index[hole] = -1;
+
+        // Swap the last dense entry into the vacated dense slot and repoint its index slot
+        auto last = static_cast<int32_t>(count - 1);
+        if (d != last)
+        {
+            auto lp = findIndexSlot(keys[last]);
+            assert(lp >= 0);
+            keys[d] = keys[last];
+            values[d] = values[last];
+            index[lp] = d;
+        }
+        --count;
+    }
+};
+} // namespace sst::voicemanager::detail
+
+#endif // INCLUDE_SST_VOICEMANAGER_VOICEMANAGER_CONTAINERS_H
@@ -17,13 +17,15 @@
 #define INCLUDE_SST_VOICEMANAGER_VOICEMANAGER_IMPL_H
 
 #include <type_traits>
+#include <bit>
 
 #include "voicemanager_constraints.h"
+#include "voicemanager_containers.h"
+#include "voicemanager_match.h"
 
 #include <iostream>
 #include <optional>
-#include <unordered_map>
-#include <unordered_set>
+#include <vector>
 
 namespace sst::voicemanager
 {
@@ -45,380 +47,2098 @@ struct VoiceManager<Cfg, Responder, MonoResponder>::Details
         std::fill(lastPBByChannel.begin(), lastPBByChannel.end(), 0);
         std::fill(sustainOn.begin(), sustainOn.end(), false);
 
-        keyStateByPort[0] = {};
+        // Every group structure is sized for maxGroups here, so adding a group or editing
+        // the hierarchy later never allocates
+        groups.reserve(maxGroups);
+        groupTour.reserve(maxGroups);
+        budgetTour.reserve(maxGroups);
+        sizeStealTree();
         guaranteeGroup(0);
     }
 
     int64_t mostRecentVoiceCounter{1};
     int64_t mostRecentTransactionID{1};
 
-    struct VoiceInfo
+    // Per voice state is split by how often it is touched. The fields every routing scan
+    // reads sit in dense per-field lanes (structure of arrays), so scanning 256 voices
+    // walks a few KB rather than striding over whole records. The rest of the bookkeeping
+    // sits in a WarmVoiceInfo record per voice, and the note id stack and original key,
+    // read only once a voice matches, in a cold side table.
+    struct VoiceLanes
+    {
+        std::array<typename Cfg::voice_t *, Cfg::maxVoiceCount> activeVoiceCookie{};
+        std::array<int16_t, Cfg::maxVoiceCount> port{}, channel{}, key{};
+        std::array<bool, Cfg::maxVoiceCount> gated{};
+        // The dense index of the voice's group in the group table
+        std::array<int32_t, Cfg::maxVoiceCount> polyGroupIndex{};
+        std::array<int64_t, Cfg::maxVoiceCount> voiceCounter{};
+    };
+
+    // A (port, channel, key) triple as the key index files it
+    struct VoiceKey
+    {
+        int16_t port{-1}, channel{-1}, key{-1};
+        bool operator==(const VoiceKey &) const = default;
+        bool concrete() const { return port != -1 && channel != -1 && key != -1; }
+    };
+    struct VoiceKeyHash
+    {
+        uint64_t operator()(const VoiceKey &k) const
+        {
+            return detail::mixHash((static_cast<uint64_t>(static_cast<uint16_t>(k.port)) << 32) |
+                                   (static_cast<uint64_t>(static_cast<uint16_t>(k.channel)) << 16) |
+                                   static_cast<uint16_t>(k.key));
+        }
+    };
+
+    static constexpr int stealModeCount{3}; // one per StealingPriorityMode
+
+    struct WarmVoiceInfo
     {
-        int16_t port{0}, channel{0}, key{0};
         int32_t noteId{-1}; // The note id is the id of the current playing note. In poly mode it is
                             // same as voice id while gated
         int32_t voiceId{
             -1}; // The voice id is the id of the current voice. When voices are re-cycled in legato
                  // and piano modes it can differ from note id. It is used for clap polymod.
 
-        static constexpr size_t noteIdStackSize{256};
-        std::array<int32_t, noteIdStackSize> noteIdStack{};
-        size_t noteIdStackPos{0};
-
-        int16_t originalPort{0}, originalChannel{0}, originalKey{0};
-
-        int64_t voiceCounter{0}, transactionId{0};
+        int64_t transactionId{0};
+        // Ring through the active voices sharing transactionId
+        int32_t transactionPrev{-1}, transactionNext{-1};
 
-        bool gated{false};
         bool gatedDueToSustain{false};
 
+        // The group id as the responder gave it; the hot lanes carry its dense index
         uint64_t polyGroup{0};
 
+        // A one bit per id (mod 64) summary of the inline note id stack, so most match
+        // attempts are refused without reading it, and how many older ids this voice has
+        // in the shared overflow set
+        uint64_t noteIdMask{0};
+        int32_t noteIdOverflowCount{0};
+
+        // Links through the other voices filed under voiceId in the voice id index
+        int32_t voiceIdPrev{-1}, voiceIdNext{-1};
+
+        // Intrusive links through the active voices of polyGroup
+        int32_t groupPrev{-1}, groupNext{-1};
+
+        // The key this voice is filed under in the key index, and its links through the
+        // other voices filed there
+        bool keyIndexed{false};
+        VoiceKey keyIndexedAs{};
+        int32_t keyIndexPrev{-1}, keyIndexNext{-1};
+
         bool alreadyStole{false};
-        typename Cfg::voice_t *activeVoiceCookie{nullptr};
+        bool inStolenSlots{false};
+
+        // Where this voice is filed as a steal candidate (see StealCandidates): the gate
+        // class, or -1 when it is not a candidate, and per priority mode its links in the
+        // group's heap (first child, next sibling, and previous sibling or parent).
+        int8_t stealGate{-1};
+        std::array<int32_t, stealModeCount> stealChild{}, stealNext{}, stealPrev{};
+    };
+
+    struct ColdVoiceInfo
+    {
+        static constexpr size_t noteIdStackSize{detail::noteIdStackSize<Cfg>()};
+        static_assert(noteIdStackSize > 0);
+        std::array<int32_t, noteIdStackSize> noteIdStack{};
+        size_t noteIdStackPos{0};
+
+        int16_t originalPort{0}, originalChannel{0}, originalKey{0};
+    };
+
+    struct NoteIdOverflowKey
+    {
+        int32_t slot{-1};
+        int32_t noteId{-1};
+        bool operator==(const NoteIdOverflowKey &) const = default;
+    };
+    struct NoteIdOverflowKeyHash
+    {
+        uint64_t operator()(const NoteIdOverflowKey &k) const
+        {
+            return detail::mixHash((static_cast<uint64_t>(static_cast<uint32_t>(k.slot)) << 32) |
+                                   static_cast<uint32_t>(k.noteId));
+        }
+    };
+    using noteIdOverflow_t = detail::FixedDenseMap<NoteIdOverflowKey, bool,
+                                                   detail::noteIdOverflowCount<Cfg>(),
+                                                   NoteIdOverflowKeyHash>;
+
+    struct VoiceTable;
+
+    /*
+     * VoiceInfo is a view of one voice slot across the hot lanes, warm record and cold
+     * table, so code handling a single voice reads as if it were still one struct. It holds
+     * a reference per field, so loops over many voices test and read the lanes by index
+     * (see Details::voiceMatches) and make a view only for a voice they go on to handle.
+     */
+    struct VoiceInfo
+    {
+        VoiceInfo(VoiceTable &t, int32_t i)
+            : table(t), index(i), port(t.hot.port[i]), channel(t.hot.channel[i]), key(t.hot.key[i]),
+              noteId(t.warm[i].noteId), voiceId(t.warm[i].voiceId),
+              noteIdStack(t.cold[i].noteIdStack), noteIdStackPos(t.cold[i].noteIdStackPos),
+              noteIdMask(t.warm[i].noteIdMask),
+              noteIdOverflowCount(t.warm[i].noteIdOverflowCount),
+              originalPort(t.cold[i].originalPort), originalChannel(t.cold[i].originalChannel),
+              originalKey(t.cold[i].originalKey), voiceCounter(t.hot.voiceCounter[i]),
+              transactionId(t.warm[i].transactionId), gated(t.hot.gated[i]),
+              gatedDueToSustain(t.warm[i].gatedDueToSustain), polyGroup(t.warm[i].polyGroup),
+              polyGroupIndex(t.hot.polyGroupIndex[i]),
+              alreadyStole(t.warm[i].alreadyStole),
+              activeVoiceCookie(t.hot.activeVoiceCookie[i])
+        {
+        }
 
-        bool matches(int16_t pt, int16_t ch, int16_t k, int32_t nid)
+        static constexpr size_t noteIdStackSize{ColdVoiceInfo::noteIdStackSize};
+
+        VoiceTable &table;
+        const int32_t index;
+        int16_t &port, &channel, &key;
+        int32_t &noteId, &voiceId;
+        std::array<int32_t, noteIdStackSize> &noteIdStack;
+        size_t &noteIdStackPos;
+        uint64_t &noteIdMask;
+        int32_t &noteIdOverflowCount;
+        int16_t &originalPort, &originalChannel, &originalKey;
+        int64_t &voiceCounter, &transactionId;
+        bool &gated, &gatedDueToSustain;
+        uint64_t &polyGroup;
+        int32_t &polyGroupIndex;
+        bool &alreadyStole;
+        typename Cfg::voice_t *&activeVoiceCookie;
+
+        bool matches(int16_t pt, int16_t ch, int16_t k, int32_t nid) const
         {
             auto res = (activeVoiceCookie != nullptr);
             res = res && (pt == -1 || port == -1 || pt == port);
             res = res && (ch == -1 || channel == -1 || ch == channel);
             res = res && (k == -1 || key == -1 || k == key);
             if (nid != -1 && noteId != -1)
-            {
-                bool anyMatch{false};
-                for (auto i = 0U; i < noteIdStackPos; ++i)
-                    anyMatch = anyMatch || (noteIdStack[i] == nid);
-                res = res && anyMatch;
-            }
+                res = res && holdsNoteId(nid);
             return res;
         }
 
-        bool matchesVoiceId(int32_t vid)
+        bool matchesVoiceId(int32_t vid) const
         {
             auto res = (activeVoiceCookie != nullptr);
             res = res && (vid == -1 || voiceId == -1 || vid == voiceId);
             return res;
         }
 
-        void snapOriginalToCurrent()
+        void snapOriginalToCurrent() const
         {
             originalPort = port;
             originalChannel = channel;
             originalKey = key;
         }
 
-        void removeNoteIdFromStack(int32_t nid)
+        static uint64_t noteIdBit(int32_t nid)
+        {
+            return 1ULL << (static_cast<uint32_t>(nid) & 63);
+        }
+
+        void setNoteId(int32_t nid) const
+        {
+            noteId = nid;
+            if (nid == -1)
+                detail::setSlotBit(table.slotsWithoutNoteId, index);
+            else
+                detail::clearSlotBit(table.slotsWithoutNoteId, index);
+        }
+
+        void setVoiceId(int32_t vid) const
+        {
+            unindexVoiceId();
+            voiceId = vid;
+            if (vid == -1)
+            {
+                detail::setSlotBit(table.slotsWithoutVoiceId, index);
+                return;
+            }
+            detail::clearSlotBit(table.slotsWithoutVoiceId, index);
+            auto &w = table.warm;
+            w[index].voiceIdPrev = -1;
+            w[index].voiceIdNext = -1;
+            if (auto *head = table.voiceIdHead.find(vid))
+            {
+                w[index].voiceIdNext = *head;
+                w[*head].voiceIdPrev = index;
+                *head = index;
+            }
+            else
+            {
+                table.voiceIdHead.insertOrAssign(vid, index);
+            }
+        }
+
+        void unindexVoiceId() const
+        {
+            auto *head = table.voiceIdHead.find(voiceId);
+            if (!head)
+                return;
+            auto &w = table.warm;
+            auto prev = w[index].voiceIdPrev, next = w[index].voiceIdNext;
+            if (prev < 0 && *head != index)
+                return; // not filed under this id
+            if (next >= 0)
+                w[next].voiceIdPrev = prev;
+            if (prev >= 0)
+                w[prev].voiceIdNext = next;
+            else if (next >= 0)
+                *head = next;
+            else
+                table.voiceIdHead.erase(voiceId);
+            w[index].voiceIdPrev = -1;
+            w[index].voiceIdNext = -1;
+        }
+
+        // Note ids live in a small inline stack, newest last. Pushing onto a full stack moves
+        // its oldest id to the overflow set shared by all voices, or forgets it if that set
+        // is full, so the newest noteIdStackSize ids are always held. Every id held, inline or
+        // overflowed, also has a holder in the table's note id index, which lists the slots
+        // holding each id for the routers.
+        bool holdsNoteId(int32_t nid) const { return holdsInlineOrOverflowed(nid); }
+
+        void indexNoteId(int32_t nid) const
+        {
+            if (nid == -1)
+                return;
+            auto &holders = table.noteIdHolders;
+            auto *head = table.noteIdHolderHead.find(nid);
+            if (head)
+            {
+                for (auto h = *head; h >= 0; h = holders[h].next)
+                    if (holders[h].slot == index)
+                        return;
+            }
+            auto h = holders.allocate();
+            assert(h >= 0); // sized to hold every id held inline or overflowed
+            holders[h].slot = index;
+            if (head)
+            {
+                holders[h].next = *head;
+                holders[*head].prev = h;
+                *head = h;
+            }
+            else
+            {
+                table.noteIdHolderHead.insertOrAssign(nid, h);
+            }
+        }
+
+        void unindexNoteId(int32_t nid) const
+        {
+            auto *head = table.noteIdHolderHead.find(nid);
+            if (!head)
+                return;
+            auto &holders = table.noteIdHolders;
+            auto h = *head;
+            while (h >= 0 && holders[h].slot != index)
+                h = holders[h].next;
+            if (h < 0)
+                return;
+            auto prev = holders[h].prev, next = holders[h].next;
+            if (next >= 0)
+                holders[next].prev = prev;
+            if (prev >= 0)
+                holders[prev].next = next;
+            else if (next >= 0)
+                *head = next;
+            else
+                table.noteIdHolderHead.erase(nid);
+            holders.release(h);
+        }
+
+        // Drop every id this voice holds, as it ends or is placed afresh.
+        void forgetNoteIds() const
         {
-            VML("- Remove note id from stack " << nid << " " << this);
-            int shift{0};
             for (auto i = 0U; i < noteIdStackPos; ++i)
+                unindexNoteId(noteIdStack[i]);
+            noteIdStackPos = 0;
+            noteIdMask = 0;
+            if (noteIdOverflowCount == 0)
+                return;
+            auto slot = index;
+            table.noteIdOverflow.eraseIf(
+                [this, slot](const auto &k, auto)
+                {
+                    if (k.slot != slot)
+                        return false;
+                    unindexNoteId(k.noteId);
+                    return true;
+                });
+            noteIdOverflowCount = 0;
+        }
+
+        void resetNoteIdStack(int32_t nid) const
+        {
+            forgetNoteIds();
+            noteIdStack[0] = nid;
+            noteIdStackPos = 1;
+            noteIdMask = noteIdBit(nid);
+            indexNoteId(nid);
+        }
+
+        void rebuildNoteIdMask() const
+        {
+            noteIdMask = 0;
+            for (auto i = 0U; i < noteIdStackPos; ++i)
+                noteIdMask |= noteIdBit(noteIdStack[i]);
+        }
+
+        void pushNoteId(int32_t nid) const
+        {
+            if (noteIdStackPos == noteIdStackSize)
             {
-                VML("   - NIDSTack at " << i << " " << noteIdStack[i] << " " << nid
-                                        << " shift=" << shift);
-                if (noteIdStack[i] == nid)
+                auto oldest = noteIdStack[0];
+                if (!table.noteIdOverflow.find({index, oldest}))
                 {
-                    shift = 1;
+                    if (table.noteIdOverflow.insertOrAssign({index, oldest}, true))
+                        ++noteIdOverflowCount;
+                    else
+                        VML("- Note id overflow full; forgetting " << oldest << " at " << index);
                 }
-                else
+                std::copy(noteIdStack.begin() + 1, noteIdStack.end(), noteIdStack.begin());
+                --noteIdStackPos;
+                rebuildNoteIdMask();
+                if (!holdsInlineOrOverflowed(oldest))
+                    unindexNoteId(oldest);
+            }
+            noteIdStack[noteIdStackPos++] = nid;
+            noteIdMask |= noteIdBit(nid);
+            indexNoteId(nid);
+        }
+
+        bool holdsInlineOrOverflowed(int32_t nid) const
+        {
+            if (noteIdMask & noteIdBit(nid))
+            {
+                for (auto i = 0U; i < noteIdStackPos; ++i)
+                    if (noteIdStack[i] == nid)
+                        return true;
+            }
+            return noteIdOverflowCount > 0 && table.noteIdOverflow.find({index, nid});
+        }
+
+        void removeNoteIdFromStack(int32_t nid) const
+        {
+            VML("- Remove note id from stack " << nid << " " << index);
+            if (noteIdMask & noteIdBit(nid))
+            {
+                size_t kept{0};
+                for (auto i = 0U; i < noteIdStackPos; ++i)
                 {
-                    noteIdStack[i] = noteIdStack[i + shift];
+                    if (noteIdStack[i] != nid)
+                        noteIdStack[kept++] = noteIdStack[i];
                 }
+                noteIdStackPos = kept;
+                rebuildNoteIdMask();
             }
-            noteIdStackPos--;
+            if (noteIdOverflowCount > 0 && table.noteIdOverflow.erase({index, nid}))
+                --noteIdOverflowCount;
+            unindexNoteId(nid);
+
             if constexpr (vmLog)
             {
-                VML("   - NIDSTack pos is now " << noteIdStackPos);
-                if (noteIdStackPos > 0 && noteIdStackPos < noteIdStack.size())
+                VML("   - NIDSTack pos is now " << noteIdStackPos << " with "
+                                                << noteIdOverflowCount << " overflowed");
+                for (auto i = 0U; i < noteIdStackPos; ++i)
                 {
-                    for (auto i = 0U; i < noteIdStackPos; ++i)
-                    {
-                        VML("      - " << i << " -> " << noteIdStack[i]);
-                    }
+                    VML("      - " << i << " -> " << noteIdStack[i]);
                 }
             }
         }
     };
-    std::array<VoiceInfo, Cfg::maxVoiceCount> voiceInfo{};
 
-    // All per-group state in one struct keyed by a single map, rather than six parallel
-    // maps. One hash lookup per group touched, atomic group lifecycle, and a single
-    // allocator to swap for std::pmr later.
+    /*
+     * The voice table holds the three tiers. voiceInfo[i] makes the VoiceInfo view of slot
+     * i and a range-for visits every slot, so loops read as they would over an array of
+     * records, while code that wants one field across many voices goes to the lanes.
+     */
+    struct VoiceTable
+    {
+        VoiceLanes hot{};
+        std::array<WarmVoiceInfo, Cfg::maxVoiceCount> warm{};
+        std::array<ColdVoiceInfo, Cfg::maxVoiceCount> cold{};
+        noteIdOverflow_t noteIdOverflow{};
+
+        // Note id to the slots holding it, and the slots whose voice has no note id (and so
+        // matches any). Bits for inactive slots may be stale; queries mask by activity.
+        struct NoteIdHash
+        {
+            uint64_t operator()(int32_t nid) const
+            {
+                return detail::mixHash(static_cast<uint32_t>(nid));
+            }
+        };
+        // Each (slot, id) pair held gets one holder, linked through the others holding that
+        // id, so the index grows with the ids held rather than ids times slots.
+        struct NoteIdHolder
+        {
+            int32_t slot{-1};
+            int32_t prev{-1}, next{-1};
+        };
+        static constexpr size_t noteIdIndexCapacity{
+            Cfg::maxVoiceCount * ColdVoiceInfo::noteIdStackSize +
+            detail::noteIdOverflowCount<Cfg>()};
+        detail::FixedPool<NoteIdHolder, noteIdIndexCapacity> noteIdHolders{};
+        detail::FixedDenseMap<int32_t, int32_t, noteIdIndexCapacity, NoteIdHash>
+            noteIdHolderHead{};
+        detail::SlotMask<Cfg::maxVoiceCount> slotsWithoutNoteId{};
+
+        // Likewise voice id to the first slot carrying it, the rest linked through the warm
+        // records, for polyphonic modulation
+        detail::FixedDenseMap<int32_t, int32_t, Cfg::maxVoiceCount, NoteIdHash> voiceIdHead{};
+        detail::SlotMask<Cfg::maxVoiceCount> slotsWithoutVoiceId{};
+
+        VoiceInfo operator[](int32_t i) { return VoiceInfo(*this, i); }
+        static constexpr size_t size() { return Cfg::maxVoiceCount; }
+
+        struct iterator
+        {
+            VoiceTable *table;
+            int32_t i;
+            VoiceInfo operator*() const { return VoiceInfo(*table, i); }
+            iterator &operator++()
+            {
+                ++i;
+                return *this;
+            }
+            bool operator!=(const iterator &o) const { return i != o.i; }
+        };
+        iterator begin() { return {this, 0}; }
+        iterator end() { return {this, static_cast<int32_t>(Cfg::maxVoiceCount)}; }
+    };
+    VoiceTable voiceInfo{};
+
+    // Reverse index from an active voice's cookie to its voiceInfo slot, so the responder's
+    // end callback finds the slot without a scan.
+    struct VoiceCookieHash
+    {
+        uint64_t operator()(const typename Cfg::voice_t *v) const
+        {
+            return detail::mixHash(static_cast<uint64_t>(reinterpret_cast<uintptr_t>(v)));
+        }
+    };
+    detail::FixedDenseMap<typename Cfg::voice_t *, int32_t, Cfg::maxVoiceCount, VoiceCookieHash>
+        slotByVoiceCookie{};
+
+    // Slots with no active voice. Placement takes the lowest free slot or, if the Cfg asks
+    // for it, the most recently freed one from a stack of freed slots (every slot on that
+    // stack is free, since placement only falls back to the bitmap once it is empty).
+    detail::SlotBitmap<Cfg::maxVoiceCount> freeVoiceSlots{};
+    detail::FixedVector<int32_t, Cfg::maxVoiceCount> recentlyFreedVoiceSlots{};
+
+    int32_t findFreeVoiceSlot()
+    {
+        if constexpr (detail::preferRecentlyFreedVoiceSlots<Cfg>())
+        {
+            if (!recentlyFreedVoiceSlots.empty())
+            {
+                auto idx = recentlyFreedVoiceSlots.back();
+                recentlyFreedVoiceSlots.pop_back();
+                assert(freeVoiceSlots.isFree(idx));
+                return idx;
+            }
+        }
+        return freeVoiceSlots.findFirstFree();
+    }
+
+    // Active voices by (port, channel, key). Each key with voices maps to the head of a list
+    // threaded through the voices' warm records; voices with a -1 anywhere in their key (which
+    // match more than one key) sit on a list of their own.
+    detail::FixedDenseMap<VoiceKey, int32_t, Cfg::maxVoiceCount, VoiceKeyHash> slotsByKey{};
+    int32_t wildcardKeyHead{-1};
+
+    void unfileVoiceKey(int32_t idx)
+    {
+        auto &vi = voiceInfo.warm[idx];
+        if (!vi.keyIndexed)
+            return;
+        auto prev = vi.keyIndexPrev, next = vi.keyIndexNext;
+        if (next >= 0)
+            voiceInfo.warm[next].keyIndexPrev = prev;
+        if (prev >= 0)
+        {
+            voiceInfo.warm[prev].keyIndexNext = next;
+        }
+        else if (vi.keyIndexedAs.concrete())
+        {
+            if (next >= 0)
+                slotsByKey.insertOrAssign(vi.keyIndexedAs, next);
+            else
+                slotsByKey.erase(vi.keyIndexedAs);
+        }
+        else
+        {
+            wildcardKeyHead = next;
+        }
+        vi.keyIndexed = false;
+        vi.keyIndexPrev = -1;
+        vi.keyIndexNext = -1;
+    }
+
+    void fileVoiceKey(int32_t idx)
+    {
+        auto &vi = voiceInfo.warm[idx];
+        const auto &hot = voiceInfo.hot;
+        vi.keyIndexedAs = {hot.port[idx], hot.channel[idx], hot.key[idx]};
+        vi.keyIndexed = true;
+        vi.keyIndexPrev = -1;
+        if (vi.keyIndexedAs.concrete())
+        {
+            auto *head = slotsByKey.find(vi.keyIndexedAs);
+            vi.keyIndexNext = head ? *head : -1;
+            if (head)
+                *head = idx;
+            else
+                slotsByKey.insertOrAssign(vi.keyIndexedAs, idx);
+        }
+        else
+        {
+            vi.keyIndexNext = wildcardKeyHead;
+            wildcardKeyHead = idx;
+        }
+        if (vi.keyIndexNext >= 0)
+            voiceInfo.warm[vi.keyIndexNext].keyIndexPrev = idx;
+    }
+
+    // Refile a voice after it starts, ends or changes port, channel or key.
+    void syncVoiceKey(int32_t idx)
+    {
+        auto &vi = voiceInfo.warm[idx];
+        const auto &hot = voiceInfo.hot;
+        auto active = hot.activeVoiceCookie[idx] != nullptr;
+        if (active && vi.keyIndexed &&
+            vi.keyIndexedAs == VoiceKey{hot.port[idx], hot.channel[idx], hot.key[idx]})
+            return;
+        unfileVoiceKey(idx);
+        if (active)
+            fileVoiceKey(idx);
+    }
+
+    // The active slots whose port, channel and key match, -1 being a wildcard on either side,
+    // as a bitmask. This is a superset for the routers which want exact port and channel, and
+    // ignores note ids, so callers confirm each hit against the voice. A fully specified query
+    // costs the voices on that key (plus any wildcard voices); otherwise we match the lanes.
+    detail::SlotMask<Cfg::maxVoiceCount> matchingVoiceSlots(int16_t pt, int16_t ch,
+                                                            int16_t k) const
+    {
+        const auto &hot = voiceInfo.hot;
+        if (pt == -1 || ch == -1 || k == -1)
+        {
+            auto res = detail::matchVoiceLanes(hot.port, hot.channel, hot.key, pt, ch, k);
+            for (size_t w = 0; w < res.size(); ++w)
+                res[w] &= ~freeVoiceSlots.freeWord(w);
+            return res;
+        }
+
+        detail::SlotMask<Cfg::maxVoiceCount> res{};
+        auto mark = [&res](int32_t s) { detail::setSlotBit(res, s); };
+        if (auto *head = slotsByKey.find(VoiceKey{pt, ch, k}))
+        {
+            for (auto s = *head; s >= 0; s = voiceInfo.warm[s].keyIndexNext)
+                mark(s);
+        }
+        for (auto s = wildcardKeyHead; s >= 0; s = voiceInfo.warm[s].keyIndexNext)
+        {
+            if (detail::laneMatches(hot.port[s], pt) && detail::laneMatches(hot.channel[s], ch) &&
+                detail::laneMatches(hot.key[s], k))
+                mark(s);
+        }
+        return res;
+    }
+
+    // VoiceInfo::matches and matchesVoiceId for slot i, read straight from the lanes. Only
+    // a voice that must be checked for a note id reaches its note id stack.
+    bool voiceMatches(int32_t i, int16_t pt, int16_t ch, int16_t k, int32_t nid)
+    {
+        const auto &hot = voiceInfo.hot;
+        if (!hot.activeVoiceCookie[i] || !detail::laneMatches(hot.port[i], pt) ||
+            !detail::laneMatches(hot.channel[i], ch) || !detail::laneMatches(hot.key[i], k))
+            return false;
+        if (nid != -1 && voiceInfo.warm[i].noteId != -1)
+            return voiceInfo[i].holdsNoteId(nid);
+        return true;
+    }
+
+    bool voiceMatchesVoiceId(int32_t i, int32_t vid) const
+    {
+        auto v = voiceInfo.warm[i].voiceId;
+        return voiceInfo.hot.activeVoiceCookie[i] && (vid == -1 || v == -1 || vid == v);
+    }
+
+    detail::SlotMask<Cfg::maxVoiceCount> activeVoiceSlots() const
+    {
+        detail::SlotMask<Cfg::maxVoiceCount> res;
+        for (size_t w = 0; w < res.size(); ++w)
+            res[w] = ~freeVoiceSlots.freeWord(w);
+        if constexpr (Cfg::maxVoiceCount % 64 != 0)
+            res.back() &= (1ULL << (Cfg::maxVoiceCount % 64)) - 1;
+        return res;
+    }
+
+    // The active slots matching voice id vid, -1 being a wildcard on either side
+    detail::SlotMask<Cfg::maxVoiceCount> matchingVoiceIdSlots(int32_t vid)
+    {
+        auto res = activeVoiceSlots();
+        if (vid == -1)
+            return res;
+        auto held = voiceInfo.slotsWithoutVoiceId;
+        if (const auto *head = voiceInfo.voiceIdHead.find(vid))
+        {
+            for (auto s = *head; s >= 0; s = voiceInfo.warm[s].voiceIdNext)
+                detail::setSlotBit(held, s);
+        }
+        for (size_t w = 0; w < res.size(); ++w)
+            res[w] &= held[w];
+        return res;
+    }
+
+    // As above, narrowed to the voices holding nid or with no note id of their own.
+    detail::SlotMask<Cfg::maxVoiceCount> matchingVoiceSlots(int16_t pt, int16_t ch, int16_t k,
+                                                            int32_t nid)
+    {
+        auto res = matchingVoiceSlots(pt, ch, k);
+        if (nid == -1)
+            return res;
+        auto held = voiceInfo.slotsWithoutNoteId;
+        if (const auto *head = voiceInfo.noteIdHolderHead.find(nid))
+        {
+            for (auto h = *head; h >= 0; h = voiceInfo.noteIdHolders[h].next)
+                detail::setSlotBit(held, voiceInfo.noteIdHolders[h].slot);
+        }
+        for (size_t w = 0; w < res.size(); ++w)
+            res[w] &= held[w];
+        return res;
+    }
+
+    // The steal candidates among one group's own voices (those whose leaf is the group),
+    // less those already picked in the current steal. Gated (including by sustain) and
+    // released voices are filed apart, as a released voice is always taken first. Each gate
+    // keeps a pairing heap per priority mode, ordered by stealsBefore and threaded through
+    // the voices' warm records, so a group holds just the roots however many voices it has,
+    // and filing or unfiling a voice is O(log voices) amortized.
+    struct StealCandidates
+    {
+        StealCandidates()
+        {
+            for (auto &r : root)
+                r.fill(-1);
+        }
+        std::array<std::array<int32_t, stealModeCount>, 2> root{}; // [gated][mode]
+    };
+
+    // All per-group state in one struct. Group ids are interned to dense indices the first
+    // time a group is guaranteed and the states sit contiguously in that order, so once an
+    // event holds its group's index every access (ancestor hops, child and sibling links,
+    // voice lists) is an array index. Groups are never removed, so an index never changes.
+    static constexpr int32_t noGroup{-1};
     struct GroupState
     {
+        uint64_t id{0};
         int32_t polyLimit{Cfg::maxVoiceCount};
         int32_t usedVoices{0};
+        // The nearest group on this group's chain (itself included) with a limit below the
+        // pool, or noGroup. Only those groups can bind a note-on before the global pool does.
+        int32_t budgetGroup{noGroup};
+        // On a limited group: the min clamped free count over the limited groups of its
+        // chain, and the deepest of them with no room left (the steal scope), or noGroup.
+        int32_t chainFree{Cfg::maxVoiceCount};
+        int32_t deepestFull{noGroup};
+        // This group's subtree is [budgetEnter, budgetExit) in the budget tour
+        int32_t budgetEnter{0}, budgetExit{0};
         StealingPriorityMode stealingPriorityMode{StealingPriorityMode::OLDEST};
         MonoPriorityMode monoPriorityMode{MonoPriorityMode::LATEST};
         PlayMode playMode{PlayMode::POLY_VOICES};
         uint64_t playModeFeatures{static_cast<uint64_t>(MonoPlayModeFeatures::NONE)};
         // A voice counts against this group and every ancestor up the parent chain.
         // Default makes every new group a root, preserving flat behavior.
-        uint64_t parentGroup{noPolyphonyGroupParent};
+        int32_t parent{noGroup};
+        // Children are a sibling list threaded through the child groups, so a subtree can
+        // be walked without a scan of every group.
+        int32_t firstChild{noGroup}, childCount{0};
+        int32_t prevSibling{noGroup}, nextSibling{noGroup};
+        // This group's subtree is [tourEnter, tourExit) in the group tour
+        int32_t tourEnter{0}, tourExit{0};
+        // Head and tail of the active voices whose leaf is this group, in placement order
+        int32_t firstVoice{-1}, lastVoice{-1};
+        StealCandidates stealCandidates{};
+    };
+    static constexpr size_t maxGroups{detail::maxPolyphonyGroupCount<Cfg>()};
+    // Group 0 is guaranteed first, so it always sits at index 0
+    static constexpr int32_t defaultGroup{0};
+    struct GroupIdHash
+    {
+        uint64_t operator()(uint64_t id) const { return detail::mixHash(id); }
     };
-    std::unordered_map<uint64_t, GroupState> groups{};
+    std::vector<GroupState> groups{};
+    detail::FixedDenseMap<uint64_t, int32_t, maxGroups, GroupIdHash> groupIndexById{};
+    // The last id resolved, since a note-on's voices nearly always share one group
+    uint64_t lastResolvedGroupId{0};
+    int32_t lastResolvedGroupIndex{noGroup};
+
+    // The index of a group through the last resolved id, or noGroup if it has never been
+    // guaranteed. A miss is never remembered.
+    int32_t groupIndex(uint64_t id)
+    {
+        if (id != lastResolvedGroupId || lastResolvedGroupIndex == noGroup)
+        {
+            auto gi = findGroupIndex(id);
+            if (gi == noGroup)
+                return noGroup;
+            lastResolvedGroupIndex = gi;
+            lastResolvedGroupId = id;
+        }
+        return lastResolvedGroupIndex;
+    }
+
+    // The index of a group, or noGroup if it has never been guaranteed
+    int32_t findGroupIndex(uint64_t id) const
+    {
+        auto *gi = groupIndexById.find(id);
+        return gi ? *gi : noGroup;
+    }
 
-    GroupState &group(uint64_t id) { return groups.at(id); }
-    const GroupState &group(uint64_t id) const { return groups.at(id); }
+    GroupState &groupAt(int32_t gi) { return groups[gi]; }
+    const GroupState &groupAt(int32_t gi) const { return groups[gi]; }
 
-    // Walk g up the parent chain; true if ancestor is hit (g itself counts), false on
-    // reaching a root. Depth cap defends against a malformed cycle.
-    bool isDescendantOrSelf(uint64_t g, uint64_t ancestor) const
+    // Every group in a preorder (Euler tour) walk of the forest, so each subtree is one
+    // contiguous run of it. The order of the roots is arbitrary. It is always current: a
+    // new group is a root and is appended, and a parent change moves the subtree's run
+    // there and then, so a steal never pays for a tree edit.
+    std::vector<int32_t> groupTour{};
+
+    void appendGroupToTour(int32_t g)
     {
-        size_t guard{0};
-        for (uint64_t c = g; c != noPolyphonyGroupParent; c = group(c).parentGroup)
+        groups[g].tourEnter = static_cast<int32_t>(groupTour.size());
+        groups[g].tourExit = groups[g].tourEnter + 1;
+        groupTour.push_back(g);
+        // A new group is an unlimited root, so the budget tour gains nothing now, but room
+        // for it is made here so a later limit change never allocates
+        groups[g].budgetEnter = static_cast<int32_t>(budgetTour.size());
+        groups[g].budgetExit = groups[g].budgetEnter;
+        refreshStealTree(g);
+    }
+
+    // A group whose limit is below the pool. An unlimited group can only be full when
+    // every voice sits in its subtree, where the global pool binds just the same, so the
+    // note-on budget only has to track the limited ones.
+    bool isLimitedGroup(int32_t g) const
+    {
+        return groupAt(g).polyLimit < static_cast<int32_t>(Cfg::maxVoiceCount);
+    }
+
+    // The limited groups in group tour order, so a subtree's limited groups are again one
+    // contiguous run. Moved along with the group tour, and rebuilt when a group gains or
+    // loses a limit.
+    std::vector<int32_t> budgetTour{};
+
+    void rebuildBudgetTour()
+    {
+        budgetTour.clear();
+        for (auto g : groupTour)
         {
-            if (c == ancestor)
-                return true;
-            if (++guard > groups.size() + 1)
-                break;
+            auto &gs = groups[g];
+            gs.budgetEnter = static_cast<int32_t>(budgetTour.size());
+            auto inherited = gs.parent == noGroup ? noGroup : groups[gs.parent].budgetGroup;
+            gs.budgetGroup = isLimitedGroup(g) ? g : inherited;
+            if (isLimitedGroup(g))
+                budgetTour.push_back(g);
         }
-        return false;
+        auto n = static_cast<int32_t>(groupTour.size());
+        for (auto g : groupTour)
+        {
+            auto &gs = groups[g];
+            gs.budgetExit = gs.tourExit < n ? groups[groupTour[gs.tourExit]].budgetEnter
+                                            : static_cast<int32_t>(budgetTour.size());
+        }
+        // Parents precede children in the tour, so each reads a current parent
+        for (auto g : budgetTour)
+            updateChainBudget(g);
+    }
+
+    // Recompute a limited group's chainFree and deepestFull from its own count and its
+    // nearest limited ancestor's cached values. Returns whether either changed.
+    bool updateChainBudget(int32_t g)
+    {
+        auto &gs = groupAt(g);
+        // Raw free can go negative under delayed termination (usedVoices outruns the
+        // limit until the end callback fires); clamp for the budget min but keep the
+        // raw sign to detect a full level.
+        auto raw = gs.polyLimit - gs.usedVoices;
+        auto free = std::max(0, raw);
+        auto full = raw <= 0 ? g : noGroup;
+        auto up = gs.parent == noGroup ? noGroup : groupAt(gs.parent).budgetGroup;
+        if (up != noGroup)
+        {
+            const auto &us = groupAt(up);
+            free = std::min(free, us.chainFree);
+            if (full == noGroup)
+                full = us.deepestFull;
+        }
+        auto changed = free != gs.chainFree || full != gs.deepestFull;
+        gs.chainFree = free;
+        gs.deepestFull = full;
+        return changed;
+    }
+
+    // The count or limit of limited groups on the chain from `changed` up to `top` moved;
+    // refresh the limited groups below top in tour order. A subtree off that chain whose
+    // root came out unchanged is skipped whole, and unlimited groups are never visited, so
+    // a wide fan of unlimited leaves under a limited parent costs nothing here.
+    void refreshChainBudgets(int32_t top, int32_t changed)
+    {
+        auto ce = groupAt(changed).tourEnter;
+        auto pos = groupAt(top).budgetEnter;
+        auto end = groupAt(top).budgetExit;
+        while (pos < end)
+        {
+            auto g = budgetTour[pos];
+            const auto &gs = groupAt(g);
+            auto onChain = gs.tourEnter <= ce && ce < gs.tourExit;
+            pos = (updateChainBudget(g) || onChain) ? pos + 1 : gs.budgetExit;
+        }
+    }
+
+    // True if g is ancestor or sits in its subtree: two compares against the tour
+    bool isDescendantOrSelf(int32_t g, int32_t ancestor) const
+    {
+        const auto &a = groupAt(ancestor);
+        auto e = groupAt(g).tourEnter;
+        return a.tourEnter <= e && e < a.tourExit;
     }
 
     // A voice in `leaf` counts against leaf and every ancestor; walk the chain applying
     // delta to each usedVoices. Mirrors how totalUsedVoices is kept, one level up per hop.
-    void adjustSubtreeUsedVoices(uint64_t leaf, int32_t delta)
+    // The cached budgets below the topmost limited group on the chain are then refreshed.
+    void adjustSubtreeUsedVoices(int32_t leaf, int32_t delta)
     {
+        if (leaf == noGroup)
+            return;
         size_t guard{0};
-        for (uint64_t g = leaf; g != noPolyphonyGroupParent; g = group(g).parentGroup)
+        auto top{noGroup};
+        for (auto g = leaf; g != noGroup; g = groupAt(g).parent)
         {
-            group(g).usedVoices += delta;
+            groupAt(g).usedVoices += delta;
+            if (isLimitedGroup(g))
+                top = g;
             if (++guard > groups.size() + 1)
                 break;
         }
+        if (top != noGroup)
+            refreshChainBudgets(top, leaf);
     }
 
-    // True if any group names groupId as its parent.
-    bool hasChildren(uint64_t groupId) const
+    // The note-on budget of a voice in group g: the min clamped free count over g and its
+    // ancestors, and the deepest of them with no room left (the steal scope), or noGroup.
+    // Both are cached on g's nearest limited group, so this is a read, not a chain walk.
+    struct ChainBudget
     {
-        for (const auto &[id, gs] : groups)
-            if (gs.parentGroup == groupId)
-                return true;
-        return false;
-    }
+        int32_t free{Cfg::maxVoiceCount};
+        int32_t deepestFull{noGroup};
+    };
 
-    // Rebuild every group's subtree-inclusive usedVoices from a scan of active voices.
-    // Called after a reparent, whose effect on the subtree counts cannot be applied
-    // incrementally.
-    void recomputeUsedVoices()
+    ChainBudget chainBudget(int32_t g) const
     {
-        for (auto &[id, gs] : groups)
-            gs.usedVoices = 0;
-        for (const auto &vi : voiceInfo)
-        {
-            if (!vi.activeVoiceCookie)
-                continue;
-            adjustSubtreeUsedVoices(vi.polyGroup, 1);
-        }
+        auto b = groupAt(g).budgetGroup;
+        if (b == noGroup)
+            return {};
+        return {groupAt(b).chainFree, groupAt(b).deepestFull};
     }
 
-    int32_t totalUsedVoices{0};
+    // A group's limit moved. Gaining or losing a limit changes which groups the budget
+    // tour holds, so it is rebuilt; otherwise only the budgets below the group move.
+    void updateGroupLimit(int32_t g, int32_t limit)
+    {
+        auto wasLimited = isLimitedGroup(g);
+        groupAt(g).polyLimit = limit;
+        if (wasLimited != isLimitedGroup(g))
+            rebuildBudgetTour();
+        else if (wasLimited)
+            refreshChainBudgets(g, g);
+    }
 
-    struct IndividualKeyState
+    // Detach a group from its parent's child list (but leave parent to the caller)
+    void unlinkGroupFromParent(int32_t child)
     {
-        int64_t transaction{0};
-        float inceptionVelocity{0.f};
-        bool heldBySustain{false};
-    };
-    using keyState_t =
-        std::array<std::array<std::unordered_map<uint64_t, IndividualKeyState>, 128>, 16>;
-    std::unordered_map<int32_t, keyState_t> keyStateByPort{};
+        auto &cs = groupAt(child);
+        if (cs.parent == noGroup)
+            return;
+        if (cs.prevSibling != noGroup)
+            groupAt(cs.prevSibling).nextSibling = cs.nextSibling;
+        else
+            groupAt(cs.parent).firstChild = cs.nextSibling;
+        if (cs.nextSibling != noGroup)
+            groupAt(cs.nextSibling).prevSibling = cs.prevSibling;
+        --groupAt(cs.parent).childCount;
+        cs.prevSibling = noGroup;
+        cs.nextSibling = noGroup;
+    }
 
-    void guaranteeGroup(uint64_t groupId)
+    void linkGroupToParent(int32_t child, int32_t parent)
     {
-        // default-constructs a GroupState (carrying every per-group default) only if absent
-        groups.try_emplace(groupId);
+        auto &cs = groupAt(child);
+        cs.parent = parent;
+        if (parent == noGroup)
+            return;
+        auto &ps = groupAt(parent);
+        cs.prevSibling = noGroup;
+        cs.nextSibling = ps.firstChild;
+        if (ps.firstChild != noGroup)
+            groupAt(ps.firstChild).prevSibling = child;
+        ps.firstChild = child;
+        ++ps.childCount;
     }
 
-    typename VoiceBeginBufferEntry<Cfg>::buffer_t voiceBeginWorkingBuffer{};
-    typename VoiceInitBufferEntry<Cfg>::buffer_t voiceInitWorkingBuffer{};
-    typename VoiceInitInstructionsEntry<Cfg>::buffer_t voiceInitInstructionsBuffer{};
-    std::array<std::array<uint16_t, 128>, 16> midiCCCache{};
+    // Add delta to the subtree size (tourExit) of g and every ancestor
+    void adjustChainTourExit(int32_t g, int32_t delta)
+    {
+        size_t guard{0};
+        for (; g != noGroup; g = groupAt(g).parent)
+        {
+            groupAt(g).tourExit += delta;
+            if (++guard > groups.size() + 1)
+                break;
+        }
+    }
+
+    void refreshBudgetExit(int32_t g)
+    {
+        auto &gs = groupAt(g);
+        gs.budgetExit = gs.tourExit < static_cast<int32_t>(groupTour.size())
+                            ? groupAt(groupTour[gs.tourExit]).budgetEnter
+                            : static_cast<int32_t>(budgetTour.size());
+    }
+
+    // Move child (and its subtree) under parent, as its first child, or make it a root with
+    // noGroup. The subtree's voices leave the old ancestor chain's counts and join the new
+    // one's, and the subtree's run of the tour is rotated to its new place: right after
+    // parent, or for a new root just past its old root's run. Only the groups between the
+    // old and new place move in the tour, the budget tour and the steal tree, and only the
+    // two chains change size, so the cost is that span plus the chains' depth rather than
+    // every group, and nothing allocates.
+    void reparentGroup(int32_t child, int32_t parent)
+    {
+        auto oldParent = groupAt(child).parent;
+        auto moved = groupAt(child).usedVoices;
+        adjustSubtreeUsedVoices(oldParent, -moved);
+
+        auto e = groupAt(child).tourEnter;
+        auto m = groupAt(child).tourExit - e;
+        auto d = e;
+        if (parent != noGroup)
+        {
+            d = groupAt(parent).tourEnter + 1;
+        }
+        else if (oldParent != noGroup)
+        {
+            auto root = oldParent;
+            while (groupAt(root).parent != noGroup)
+                root = groupAt(root).parent;
+            d = groupAt(root).tourExit;
+        }
+
+        // From here each tourExit - tourEnter is the group's new subtree size, and the
+        // tour positions are fixed up below
+        adjustChainTourExit(oldParent, -m);
+        unlinkGroupFromParent(child);
+        linkGroupToParent(child, parent);
+        adjustChainTourExit(parent, m);
+
+        auto lo = std::min(d, e), hi = std::max(d, e + m);
+        if (d != e && d != e + m)
+        {
+            auto countBefore = groupAt(groupTour[lo]).budgetEnter;
+            auto t = groupTour.begin();
+            if (d < e)
+                std::rotate(t + d, t + e, t + e + m);
+            else
+                std::rotate(t + e, t + e + m, t + d);
+
+            for (auto q = lo; q < hi; ++q)
+            {
+                auto &gs = groupAt(groupTour[q]);
+                auto size = gs.tourExit - gs.tourEnter;
+                gs.tourEnter = q;
+                gs.tourExit = q + size;
+                gs.budgetEnter = countBefore;
+                if (isLimitedGroup(groupTour[q]))
+                    budgetTour[countBefore++] = groupTour[q];
+            }
+            for (auto q = lo; q < hi; ++q)
+                refreshBudgetExit(groupTour[q]);
+            refreshStealTreeRange(lo, hi);
+        }
+        for (auto g = oldParent; g != noGroup; g = groupAt(g).parent)
+            refreshBudgetExit(g);
+        for (auto g = parent; g != noGroup; g = groupAt(g).parent)
+            refreshBudgetExit(g);
+
+        // The subtree now inherits its budget from the new chain
+        const auto &cs = groupAt(child);
+        for (auto q = cs.tourEnter; q < cs.tourExit; ++q)
+        {
+            auto g = groupTour[q];
+            auto up = groupAt(g).parent;
+            groupAt(g).budgetGroup =
+                isLimitedGroup(g) ? g : (up == noGroup ? noGroup : groupAt(up).budgetGroup);
+        }
+        adjustSubtreeUsedVoices(parent, moved);
+        for (auto b = cs.budgetEnter; b < cs.budgetExit; ++b)
+            updateChainBudget(budgetTour[b]);
+    }
+
+    void linkVoiceToGroup(int32_t idx)
+    {
+        auto &vi = voiceInfo.warm[idx];
+        auto &gs = groupAt(voiceInfo.hot.polyGroupIndex[idx]);
+        vi.groupPrev = gs.lastVoice;
+        vi.groupNext = -1;
+        if (gs.lastVoice >= 0)
+            voiceInfo.warm[gs.lastVoice].groupNext = idx;
+        else
+            gs.firstVoice = idx;
+        gs.lastVoice = idx;
+    }
+
+    void unlinkVoiceFromGroup(int32_t idx)
+    {
+        auto &vi = voiceInfo.warm[idx];
+        auto &gs = groupAt(voiceInfo.hot.polyGroupIndex[idx]);
+        if (vi.groupPrev >= 0)
+            voiceInfo.warm[vi.groupPrev].groupNext = vi.groupNext;
+        else
+            gs.firstVoice = vi.groupNext;
+        if (vi.groupNext >= 0)
+            voiceInfo.warm[vi.groupNext].groupPrev = vi.groupPrev;
+        else
+            gs.lastVoice = vi.groupPrev;
+        vi.groupPrev = -1;
+        vi.groupNext = -1;
+    }
+
+    // Visit the slot of every active voice whose leaf group is gi. The next link is
+    // read before f runs so f may end (and so unlink) the voice it is handed.
+    template <typename F> void forEachVoiceInGroup(int32_t gi, F &&f)
+    {
+        auto idx = groupAt(gi).firstVoice;
+        while (idx >= 0)
+        {
+            auto next = voiceInfo.warm[idx].groupNext;
+            f(idx);
+            idx = next;
+        }
+    }
+
+    // As above but in slot order, for the paths whose choice of voice (and the order the
+    // responder hears about them) has always followed the slots. A voice f ends before its
+    // turn comes is skipped.
+    detail::FixedVector<int32_t, Cfg::maxVoiceCount> groupVoiceScratch{};
+    template <typename F> void forEachVoiceInGroupBySlot(int32_t gi, F &&f)
+    {
+        groupVoiceScratch.clear();
+        forEachVoiceInGroup(gi, [this](auto idx) { groupVoiceScratch.push_back(idx); });
+        std::sort(groupVoiceScratch.begin(), groupVoiceScratch.end());
+        for (auto idx : groupVoiceScratch)
+        {
+            if (voiceInfo.hot.activeVoiceCookie[idx])
+                f(idx);
+        }
+    }
+
+    // True if any group names gi as its parent.
+    bool hasChildren(int32_t gi) const { return groupAt(gi).childCount > 0; }
+
+    int32_t totalUsedVoices{0};
+
+    struct IndividualKeyState
+    {
+        int64_t transaction{0};
+        float inceptionVelocity{0.f};
+        bool heldBySustain{false};
+    };
+
+    // Held keys are only ever consulted for MONO_NOTES groups (the release-to-key retrigger
+    // and the any-other-key-held checks), and setPlaymode clears a group's keys whenever its
+    // mode changes, so only mono groups are recorded. The store is a fixed, preallocated
+    // table keyed by (port, channel, key, group) so recording and clearing keys never
+    // allocates, and scans over it cost the keys actually held.
+    struct KeyStateKey
+    {
+        int32_t port{0};
+        int16_t channel{0}, key{0};
+        uint64_t polyGroup{0};
+
+        bool operator==(const KeyStateKey &) const = default;
+    };
+    struct KeyStateKeyHash
+    {
+        uint64_t operator()(const KeyStateKey &k) const
+        {
+            auto pck = (static_cast<uint64_t>(static_cast<uint32_t>(k.port)) << 32) |
+                       (static_cast<uint64_t>(static_cast<uint16_t>(k.channel)) << 16) |
+                       static_cast<uint64_t>(static_cast<uint16_t>(k.key));
+            return detail::mixHash(pck ^ (k.polyGroup * 0x9e3779b97f4a7c15ULL));
+        }
+    };
+    static constexpr size_t maxHeldKeyStates{detail::maxHeldKeyStateCount<Cfg>()};
+
+    // Each held key is a node in a stable pool, threaded onto one of two lists for its
+    // (port, group): keys physically down, and keys only held by the sustain pedal. Lists
+    // are kept in release-to-latest order (the tail is the newest transaction) and the same
+    // keys are mirrored into per-channel 128 bit masks, so picking the key a mono group
+    // returns to is a list tail or a count-leading/trailing-zeros per occupied channel.
+    struct HeldKeyNode
+    {
+        KeyStateKey where{};
+        IndividualKeyState state{};
+        int32_t prev{-1}, next{-1};
+        // The other groups' nodes for the same (port, channel, key)
+        int32_t keyPrev{-1}, keyNext{-1};
+    };
+    struct MonoHeldKeys
+    {
+        // indexed by heldBySustain
+        std::array<int32_t, 2> head{-1, -1}, tail{-1, -1};
+        std::array<int32_t, 2> count{0, 0};
+        std::array<uint16_t, 2> channelMask{0, 0};
+    };
+    using keyBits_t = std::array<std::array<uint64_t, 2>, 2>; // [heldBySustain][key / 64]
+
+    detail::FixedPool<HeldKeyNode, maxHeldKeyStates> heldKeyNodes{};
+    detail::FixedDenseMap<KeyStateKey, int32_t, maxHeldKeyStates, KeyStateKeyHash> keyStates{};
+    // Keyed (port, -1, -1, group) and (port, channel, -1, group) respectively. Each entry
+    // holds at least one key so neither can outgrow the node pool.
+    detail::FixedDenseMap<KeyStateKey, MonoHeldKeys, maxHeldKeyStates, KeyStateKeyHash>
+        monoHeldKeys{};
+    detail::FixedDenseMap<KeyStateKey, keyBits_t, maxHeldKeyStates, KeyStateKeyHash>
+        monoHeldKeyBits{};
+    // Keyed (port, channel, key, 0), the head of that key's nodes across every group, so a
+    // note off or pedal change touches the nodes for its key rather than every held key.
+    detail::FixedDenseMap<KeyStateKey, int32_t, maxHeldKeyStates, KeyStateKeyHash>
+        heldKeysByKey{};
+
+    static bool isInKeyRange(int channel, int key)
+    {
+        return channel >= 0 && channel < 16 && key >= 0 && key < 128;
+    }
+
+    // Recency order: the newer transaction is later, and ties put the lower channel then
+    // key later, matching what a channel-major sweep for the maximum transaction would pick.
+    static bool heldKeyIsLater(const HeldKeyNode &a, const HeldKeyNode &b)
+    {
+        if (a.state.transaction != b.state.transaction)
+            return a.state.transaction > b.state.transaction;
+        return a.where.channel < b.where.channel ||
+               (a.where.channel == b.where.channel && a.where.key < b.where.key);
+    }
+
+    void linkHeldKey(int32_t n)
+    {
+        auto &node = heldKeyNodes[n];
+        const auto &w = node.where;
+        auto cat = node.state.heldBySustain ? 1 : 0;
+        auto *mh = monoHeldKeys.find({w.port, -1, -1, w.polyGroup});
+        auto *bits = monoHeldKeyBits.find({w.port, w.channel, -1, w.polyGroup});
+        assert(mh && bits);
+
+        // Transactions only grow, so a fresh key lands at the tail without stepping back
+        auto after = mh->tail[cat];
+        while (after >= 0 && !heldKeyIsLater(node, heldKeyNodes[after]))
+            after = heldKeyNodes[after].prev;
+        node.prev = after;
+        node.next = after >= 0 ? heldKeyNodes[after].next : mh->head[cat];
+        if (node.prev >= 0)
+            heldKeyNodes[node.prev].next = n;
+        else
+            mh->head[cat] = n;
+        if (node.next >= 0)
+            heldKeyNodes[node.next].prev = n;
+        else
+            mh->tail[cat] = n;
+
+        (*bits)[cat][w.key >> 6] |= 1ULL << (w.key & 63);
+        mh->channelMask[cat] |= static_cast<uint16_t>(1U << w.channel);
+        ++mh->count[cat];
+    }
+
+    void unlinkHeldKey(int32_t n)
+    {
+        auto &node = heldKeyNodes[n];
+        const auto &w = node.where;
+        auto cat = node.state.heldBySustain ? 1 : 0;
+        auto *mh = monoHeldKeys.find({w.port, -1, -1, w.polyGroup});
+        auto *bits = monoHeldKeyBits.find({w.port, w.channel, -1, w.polyGroup});
+        assert(mh && bits);
+
+        if (node.prev >= 0)
+            heldKeyNodes[node.prev].next = node.next;
+        else
+            mh->head[cat] = node.next;
+        if (node.next >= 0)
+            heldKeyNodes[node.next].prev = node.prev;
+        else
+            mh->tail[cat] = node.prev;
+        node.prev = -1;
+        node.next = -1;
+
+        auto &cb = (*bits)[cat];
+        cb[w.key >> 6] &= ~(1ULL << (w.key & 63));
+        if (cb[0] == 0 && cb[1] == 0)
+            mh->channelMask[cat] &= static_cast<uint16_t>(~(1U << w.channel));
+        --mh->count[cat];
+    }
+
+    void linkHeldKeyByKey(int32_t n)
+    {
+        auto &node = heldKeyNodes[n];
+        const auto &w = node.where;
+        KeyStateKey byKey{w.port, w.channel, w.key, 0};
+        auto *head = heldKeysByKey.find(byKey);
+        node.keyPrev = -1;
+        node.keyNext = head ? *head : -1;
+        if (node.keyNext >= 0)
+            heldKeyNodes[node.keyNext].keyPrev = n;
+        heldKeysByKey.insertOrAssign(byKey, n);
+    }
+
+    void unlinkHeldKeyByKey(int32_t n)
+    {
+        auto &node = heldKeyNodes[n];
+        const auto &w = node.where;
+        KeyStateKey byKey{w.port, w.channel, w.key, 0};
+        if (node.keyPrev >= 0)
+            heldKeyNodes[node.keyPrev].keyNext = node.keyNext;
+        else if (node.keyNext >= 0)
+            heldKeysByKey.insertOrAssign(byKey, node.keyNext);
+        else
+            heldKeysByKey.erase(byKey);
+        if (node.keyNext >= 0)
+            heldKeyNodes[node.keyNext].keyPrev = node.keyPrev;
+        node.keyPrev = -1;
+        node.keyNext = -1;
+    }
+
+    // Visit every group's node for (port, channel, key). The next link is read before f
+    // runs so f may drop the node it is handed.
+    template <typename F> void forEachHeldKeyNode(int16_t port, int16_t channel, int16_t key, F &&f)
+    {
+        auto *head = heldKeysByKey.find({port, channel, key, 0});
+        auto n = head ? *head : -1;
+        while (n >= 0)
+        {
+            auto next = heldKeyNodes[n].keyNext;
+            f(n);
+            n = next;
+        }
+    }
+
+    // Unlink a node and return it to the pool, dropping its group and channel entries once
+    // they hold no keys. The caller removes the keyStates entry.
+    void dropHeldKeyNode(int32_t n)
+    {
+        unlinkHeldKey(n);
+        unlinkHeldKeyByKey(n);
+        const auto w = heldKeyNodes[n].where;
+        auto *mh = monoHeldKeys.find({w.port, -1, -1, w.polyGroup});
+        if (mh->head[0] < 0 && mh->head[1] < 0)
+            monoHeldKeys.erase({w.port, -1, -1, w.polyGroup});
+        auto *bits = monoHeldKeyBits.find({w.port, w.channel, -1, w.polyGroup});
+        if (((*bits)[0][0] | (*bits)[0][1] | (*bits)[1][0] | (*bits)[1][1]) == 0)
+            monoHeldKeyBits.erase({w.port, w.channel, -1, w.polyGroup});
+        heldKeyNodes.release(n);
+    }
+
+    void recordKeyState(int16_t port, int16_t channel, int16_t key, int32_t gi,
+                        int64_t transaction, float velocity)
+    {
+        if (groupAt(gi).playMode != PlayMode::MONO_NOTES || !isInKeyRange(channel, key))
+            return;
+
+        auto polyGroup = groupAt(gi).id;
+        KeyStateKey where{port, channel, key, polyGroup};
+        if (auto *existing = keyStates.find(where))
+        {
+            // Restriking a key (even one held by sustain) makes it held and latest again
+            unlinkHeldKey(*existing);
+            heldKeyNodes[*existing].state = {transaction, velocity};
+            linkHeldKey(*existing);
+            return;
+        }
+
+        auto n = heldKeyNodes.allocate();
+        if (n < 0)
+        {
+            // Defined overflow: the key plays but cannot be returned to on a mono release
+            VML("- Key state table full; not recording " << port << "/" << channel << "/" << key
+                                                         << " pg=" << polyGroup);
+            return;
+        }
+        heldKeyNodes[n].where = where;
+        heldKeyNodes[n].state = {transaction, velocity};
+        keyStates.insertOrAssign(where, n);
+        if (!monoHeldKeys.find({port, -1, -1, polyGroup}))
+            monoHeldKeys.insertOrAssign({port, -1, -1, polyGroup}, MonoHeldKeys{});
+        if (!monoHeldKeyBits.find({port, channel, -1, polyGroup}))
+            monoHeldKeyBits.insertOrAssign({port, channel, -1, polyGroup}, keyBits_t{});
+        linkHeldKey(n);
+        linkHeldKeyByKey(n);
+    }
+
+    void markKeyHeldBySustain(int16_t port, int16_t channel, int16_t key)
+    {
+        forEachHeldKeyNode(port, channel, key,
+                           [&](auto n)
+                           {
+                               auto &node = heldKeyNodes[n];
+                               if (node.state.heldBySustain)
+                                   return;
+                               unlinkHeldKey(n);
+                               node.state.heldBySustain = true;
+                               linkHeldKey(n);
+                           });
+    }
+
+    void clearKeyState(int16_t port, int16_t channel, int16_t key)
+    {
+        forEachHeldKeyNode(port, channel, key,
+                           [&](auto n)
+                           {
+                               keyStates.erase(heldKeyNodes[n].where);
+                               dropHeldKeyNode(n);
+                           });
+    }
+
+    void clearGroupKeyState(uint64_t polyGroup)
+    {
+        keyStates.eraseIf(
+            [&](const auto &k, auto n)
+            {
+                if (k.polyGroup != polyGroup)
+                    return false;
+                dropHeldKeyNode(n);
+                return true;
+            });
+    }
+
+    void clearKeysHeldBySustain(int16_t port, uint64_t polyGroup)
+    {
+        while (auto *mh = monoHeldKeys.find({port, -1, -1, polyGroup}))
+        {
+            auto n = mh->head[1];
+            if (n < 0)
+                break;
+            keyStates.erase(heldKeyNodes[n].where);
+            dropHeldKeyNode(n);
+        }
+    }
+
+    /*
+     * Find the key a mono group returns to among keys held (or only held by sustain) on a
+     * port, honoring the group's ON_RELEASE_TO_ features. Leaves the outputs untouched if
+     * there is no candidate.
+     */
+    void findBestHeldKey(int16_t port, uint64_t polyGroup, uint64_t features, bool bySustain,
+                         int &dch, int &dk, float &dvel) const
+    {
+        auto *mh = monoHeldKeys.find({port, -1, -1, polyGroup});
+        if (!mh)
+            return;
+        auto cat = bySustain ? 1 : 0;
+
+        if (features & static_cast<uint64_t>(MonoPlayModeFeatures::ON_RELEASE_TO_LATEST))
+        {
+            if (mh->tail[cat] >= 0)
+            {
+                const auto &node = heldKeyNodes[mh->tail[cat]];
+                dch = node.where.channel;
+                dk = node.where.key;
+                dvel = node.state.inceptionVelocity;
+            }
+            return;
+        }
+
+        bool toHighest =
+            features & static_cast<uint64_t>(MonoPlayModeFeatures::ON_RELEASE_TO_HIGHEST);
+        bool toLowest =
+            features & static_cast<uint64_t>(MonoPlayModeFeatures::ON_RELEASE_TO_LOWEST);
+        if (!toHighest && !toLowest)
+            return;
+
+        // Channels ascend, so a strict compare keeps the lowest channel on a tie. As with
+        // the original sweep, release-to-highest never picks key 0.
+        int bestCh{-1}, bestKey{toHighest ? 0 : 128};
+        for (uint32_t m = mh->channelMask[cat]; m; m &= m - 1)
+        {
+            auto ch = std::countr_zero(m);
+            const auto &b = (*monoHeldKeyBits.find({port, static_cast<int16_t>(ch), -1,
+                                                    polyGroup}))[cat];
+            int k;
+            if (toHighest)
+                k = b[1] ? 127 - std::countl_zero(b[1]) : 63 - std::countl_zero(b[0]);
+            else
+                k = b[0] ? std::countr_zero(b[0]) : 64 + std::countr_zero(b[1]);
+            if (toHighest ? k > bestKey : k < bestKey)
+            {
+                bestKey = k;
+                bestCh = ch;
+            }
+        }
+        if (bestCh >= 0)
+        {
+            auto n = *keyStates.find(
+                {port, static_cast<int16_t>(bestCh), static_cast<int16_t>(bestKey), polyGroup});
+            dch = bestCh;
+            dk = bestKey;
+            dvel = heldKeyNodes[n].state.inceptionVelocity;
+        }
+    }
+
+    // Intern groupId, default-constructing its GroupState (carrying every per-group default)
+    // if it is new, and return its index. With maxGroups already interned a new id gets
+    // noGroup, and the caller leaves it alone.
+    int32_t guaranteeGroup(uint64_t groupId)
+    {
+        if (auto gi = findGroupIndex(groupId); gi != noGroup)
+            return gi;
+        if (groups.size() == maxGroups)
+        {
+            VML("- Group table full; not adding group " << groupId);
+            return noGroup;
+        }
+        auto gi = static_cast<int32_t>(groups.size());
+        groupIndexById.insertOrAssign(groupId, gi);
+        groups.emplace_back();
+        groups.back().id = groupId;
+        appendGroupToTour(gi);
+        return gi;
+    }
+
+    typename VoiceBeginBufferEntry<Cfg>::buffer_t voiceBeginWorkingBuffer{};
+    // The group index of each begin buffer entry, resolved once per note-on
+    std::array<int32_t, Cfg::maxVoiceCount> voiceBeginGroupIndex{};
+    // Per note-on group tallies. A transaction launches at most maxVoiceCount voices so it
+    // touches at most that many groups; member resident so note-on never allocates.
+    detail::FixedLinearMap<int32_t, int32_t, Cfg::maxVoiceCount> createdByPolyGroup{};
+    detail::FixedVector<int32_t, Cfg::maxVoiceCount> monoGroups{};
+    typename VoiceInitBufferEntry<Cfg>::buffer_t voiceInitWorkingBuffer{};
+    typename VoiceInitInstructionsEntry<Cfg>::buffer_t voiceInitInstructionsBuffer{};
+    std::array<std::array<uint16_t, 128>, 16> midiCCCache{};
     std::array<bool, 16> sustainOn{};
     std::array<int16_t, 16> lastPBByChannel{};
 
-    void doMonoPitchBend(int16_t port, int16_t channel, int16_t pb14bit)
+    void doMonoPitchBend(int16_t port, int16_t channel, int16_t pb14bit)
+    {
+        if (channel >= 0 && channel < static_cast<int16_t>(lastPBByChannel.size()))
+            lastPBByChannel[channel] = static_cast<int16_t>(pb14bit - 8192);
+
+        vm.monoResponder.setMIDIPitchBend(channel, pb14bit);
+    }
+
+    void doMPEPitchBend(int16_t port, int16_t channel, int16_t pb14bit)
+    {
+        const auto &hot = voiceInfo.hot;
+        auto hits = matchingVoiceSlots(port, channel, -1);
+        for (auto idx : detail::SetBits{hits})
+        {
+            if (voiceMatches(idx, port, channel, -1, -1) &&
+                hot.gated[idx]) // all keys and notes on a channel for midi PB
+            {
+                vm.responder.setVoiceMIDIMPEChannelPitchBend(hot.activeVoiceCookie[idx], pb14bit);
+            }
+        }
+    }
+
+    void doMonoChannelPressure(int16_t port, int16_t channel, int8_t val)
+    {
+        vm.monoResponder.setMIDIChannelPressure(channel, val);
+    }
+
+    void doMPEChannelPressure(int16_t port, int16_t channel, int8_t val)
+    {
+        const auto &hot = voiceInfo.hot;
+        auto hits = matchingVoiceSlots(port, channel, -1);
+        for (auto idx : detail::SetBits{hits})
+        {
+            if (hot.activeVoiceCookie[idx] && hot.port[idx] == port &&
+                hot.channel[idx] == channel && hot.gated[idx])
+            {
+                vm.responder.setVoiceMIDIMPEChannelPressure(hot.activeVoiceCookie[idx], val);
+            }
+        }
+    }
+
+    void deliverPitchBend(int16_t port, int16_t channel, int16_t pb14bit)
+    {
+        if (vm.dialect == MIDI1Dialect::MIDI1)
+        {
+            doMonoPitchBend(port, channel, pb14bit);
+        }
+        else if (vm.dialect == MIDI1Dialect::MIDI1_MPE)
+        {
+            if (channel == vm.mpeGlobalChannel)
+            {
+                doMonoPitchBend(port, -1, pb14bit);
+            }
+            else
+            {
+                doMPEPitchBend(port, channel, pb14bit);
+            }
+        }
+        else
+        {
+            // Code this dialect! What is it even?
+            assert(false);
+        }
+    }
+
+    void deliverChannelPressure(int16_t port, int16_t channel, int8_t pat)
+    {
+        if (vm.dialect == MIDI1Dialect::MIDI1)
+        {
+            doMonoChannelPressure(port, channel, pat);
+        }
+        else if (vm.dialect == MIDI1Dialect::MIDI1_MPE)
+        {
+            if (channel == vm.mpeGlobalChannel)
+            {
+                doMonoChannelPressure(port, channel, pat);
+            }
+            else
+            {
+                doMPEChannelPressure(port, channel, pat);
+            }
+        }
+    }
+
+    void deliverPolyphonicAftertouch(int16_t port, int16_t channel, int16_t key, int8_t pat)
+    {
+        auto hits = matchingVoiceSlots(port, channel, key);
+        for (auto idx : detail::SetBits{hits})
+        {
+            if (voiceMatches(idx, port, channel, key, -1))
+            {
+                vm.responder.setPolyphonicAftertouch(voiceInfo.hot.activeVoiceCookie[idx], pat);
+            }
+        }
+    }
+
+    void deliverMIDI1CC(int16_t port, int16_t channel, int8_t cc, int8_t val)
+    {
+        if (vm.dialect == MIDI1Dialect::MIDI1_MPE && channel != vm.mpeGlobalChannel &&
+            cc == vm.mpeTimbreCC)
+        {
+            const auto &hot = voiceInfo.hot;
+            auto hits = matchingVoiceSlots(port, channel, -1);
+            for (auto idx : detail::SetBits{hits})
+            {
+                if (hot.activeVoiceCookie[idx] && hot.port[idx] == port &&
+                    hot.channel[idx] == channel && hot.gated[idx])
+                {
+                    vm.responder.setVoiceMIDIMPETimbre(hot.activeVoiceCookie[idx], val);
+                }
+            }
+        }
+        else
+        {
+            midiCCCache[channel][cc] = val;
+            vm.monoResponder.setMIDI1CC(channel, cc, val);
+        }
+    }
+
+    // Controller updates held back under coalesceControllers, latest value per key. index is
+    // the key for aftertouch, the CC number for a CC, and unused (-1) otherwise.
+    enum struct CoalescedController : uint8_t
+    {
+        PITCH_BEND,
+        CHANNEL_PRESSURE,
+        POLYPHONIC_AFTERTOUCH,
+        MIDI1_CC
+    };
+    struct CoalescedKey
+    {
+        CoalescedController kind{CoalescedController::PITCH_BEND};
+        int16_t port{-1}, channel{-1}, index{-1};
+        bool operator==(const CoalescedKey &) const = default;
+    };
+    struct CoalescedKeyHash
+    {
+        uint64_t operator()(const CoalescedKey &k) const
+        {
+            return detail::mixHash((static_cast<uint64_t>(k.kind) << 48) |
+                                   (static_cast<uint64_t>(static_cast<uint16_t>(k.port)) << 32) |
+                                   (static_cast<uint64_t>(static_cast<uint16_t>(k.channel)) << 16) |
+                                   static_cast<uint16_t>(k.index));
+        }
+    };
+    detail::FixedDenseMap<CoalescedKey, int16_t, detail::maxCoalescedControllerCount<Cfg>(),
+                          CoalescedKeyHash>
+        coalescedControllers{};
+
+    // Hold back a controller value; false if there is no room, and it should go out now
+    bool coalesceController(CoalescedController kind, int16_t port, int16_t channel,
+                            int16_t index, int16_t value)
+    {
+        return coalescedControllers.insertOrAssign({kind, port, channel, index}, value) !=
+               nullptr;
+    }
+
+    void deliverCoalesced(const CoalescedKey &k, int16_t value, uint32_t sampleOffset)
+    {
+        if constexpr (HasCoalescedControllerOffset<Responder>)
+            vm.responder.setCoalescedControllerOffset(sampleOffset);
+        if constexpr (HasCoalescedControllerOffset<MonoResponder>)
+            vm.monoResponder.setCoalescedControllerOffset(sampleOffset);
+        switch (k.kind)
+        {
+        case CoalescedController::PITCH_BEND:
+            deliverPitchBend(k.port, k.channel, value);
+            break;
+        case CoalescedController::CHANNEL_PRESSURE:
+            deliverChannelPressure(k.port, k.channel, static_cast<int8_t>(value));
+            break;
+        case CoalescedController::POLYPHONIC_AFTERTOUCH:
+            deliverPolyphonicAftertouch(k.port, k.channel, k.index, static_cast<int8_t>(value));
+            break;
+        case CoalescedController::MIDI1_CC:
+            deliverMIDI1CC(k.port, k.channel, static_cast<int8_t>(k.index),
+                           static_cast<int8_t>(value));
+            break;
+        }
+    }
+
+    void flushAllCoalescedControllers(uint32_t sampleOffset)
+    {
+        if (coalescedControllers.empty())
+            return;
+        coalescedControllers.forEach([this, sampleOffset](const auto &k, auto v)
+                                     { deliverCoalesced(k, v, sampleOffset); });
+        coalescedControllers.clear();
+    }
+
+    // Deliver what is held for one channel (on any port, as the mono caches are per channel)
+    // ahead of a note or pedal event on it. A -1 wildcard channel on either side matches. In
+    // MPE the global channel's bend and controllers apply to every member channel's notes, so
+    // they go out too. sampleOffset is where that event sits in the block.
+    void flushCoalescedControllers(int16_t channel, uint32_t sampleOffset)
+    {
+        if (coalescedControllers.empty())
+            return;
+        int16_t global = vm.dialect == MIDI1Dialect::MIDI1_MPE ? vm.mpeGlobalChannel : -2;
+        coalescedControllers.eraseIf(
+            [this, channel, global, sampleOffset](const auto &k, auto v)
+            {
+                if (k.channel != channel && k.channel != -1 && channel != -1 &&
+                    k.channel != global)
+                    return false;
+                deliverCoalesced(k, v, sampleOffset);
+                return true;
+            });
+    }
+
+    // The offset of the event processEvents is dispatching, so a flush it triggers lands
+    // there; 0 outside it, where the single-event calls carry no timing. While a block is
+    // dispatching, controllers coalesce as if coalesceControllers were on.
+    uint32_t eventSampleOffset{0};
+    bool dispatchingBlock{false};
+
+    // The voices one note launched share a transactionId and sit on a ring threaded through
+    // VoiceInfo. A voice only ever joins the current transaction, so holding one member of
+    // that ring is enough to find it.
+    int32_t currentTransactionSlot{-1};
+    detail::FixedVector<int32_t, Cfg::maxVoiceCount> transactionSiblings{};
+
+    void joinCurrentTransaction(int32_t idx)
+    {
+        auto &vi = voiceInfo.warm[idx];
+        assert(vi.transactionId == mostRecentTransactionID);
+        auto c = currentTransactionSlot;
+        if (c >= 0 && voiceInfo.warm[c].transactionId == vi.transactionId)
+        {
+            vi.transactionPrev = c;
+            vi.transactionNext = voiceInfo.warm[c].transactionNext;
+            voiceInfo.warm[vi.transactionNext].transactionPrev = idx;
+            voiceInfo.warm[c].transactionNext = idx;
+        }
+        else
+        {
+            vi.transactionPrev = idx;
+            vi.transactionNext = idx;
+        }
+        currentTransactionSlot = idx;
+    }
+
+    void leaveTransaction(int32_t idx)
+    {
+        auto &vi = voiceInfo.warm[idx];
+        auto next = vi.transactionNext;
+        if (next == idx)
+        {
+            next = -1;
+        }
+        else
+        {
+            voiceInfo.warm[vi.transactionPrev].transactionNext = next;
+            voiceInfo.warm[next].transactionPrev = vi.transactionPrev;
+        }
+        if (currentTransactionSlot == idx)
+            currentTransactionSlot = next;
+        vi.transactionPrev = -1;
+        vi.transactionNext = -1;
+    }
+
+    // Fill transactionSiblings with the other voices in idx's transaction. Gathered up front
+    // since terminating a voice may end it, and so unlink it, at once.
+    void gatherTransactionSiblings(int32_t idx)
+    {
+        transactionSiblings.clear();
+        for (auto s = voiceInfo.warm[idx].transactionNext; s != idx;
+             s = voiceInfo.warm[s].transactionNext)
+            transactionSiblings.push_back(s);
+    }
+
+    // Book a slot whose fields (cookie and polyGroup included) placement has just filled
+    // into the group voice list, the cookie index and the used voice counts.
+    void activateVoiceSlot(int32_t idx)
+    {
+        auto vi = voiceInfo[idx];
+        [[maybe_unused]] auto *res = slotByVoiceCookie.insertOrAssign(vi.activeVoiceCookie, idx);
+        assert(res);
+        freeVoiceSlots.markUsed(idx);
+        linkVoiceToGroup(idx);
+        joinCurrentTransaction(idx);
+        syncStealCandidate(idx);
+        syncVoiceKey(idx);
+        adjustSubtreeUsedVoices(vi.polyGroupIndex, 1);
+        ++totalUsedVoices;
+    }
+
+    void endVoice(typename Cfg::voice_t *v)
+    {
+        auto *slot = slotByVoiceCookie.find(v);
+        if (!slot)
+            return;
+
+        auto idx = *slot;
+        slotByVoiceCookie.erase(v);
+
+        auto vi = voiceInfo[idx];
+        assert(vi.activeVoiceCookie == v);
+        unlinkVoiceFromGroup(idx);
+        leaveTransaction(idx);
+        vi.forgetNoteIds();
+        vi.unindexVoiceId();
+        adjustSubtreeUsedVoices(vi.polyGroupIndex, -1);
+        --totalUsedVoices;
+        VML("  - Ending voice " << vi.activeVoiceCookie << " pg=" << vi.polyGroup
+                                << " used now is " << groupAt(vi.polyGroupIndex).usedVoices << " ("
+                                << totalUsedVoices << ")");
+        vi.activeVoiceCookie = nullptr;
+        syncStealCandidate(idx);
+        syncVoiceKey(idx);
+        freeVoiceSlots.markFree(idx);
+        if constexpr (detail::preferRecentlyFreedVoiceSlots<Cfg>())
+            recentlyFreedVoiceSlots.push_back(idx);
+    }
+
+    // Every slot marked alreadyStole since the last clearAlreadyStole, so the reset touches
+    // only those
+    detail::FixedVector<int32_t, Cfg::maxVoiceCount> stolenSlots{};
+
+    bool stealAgeLess(int32_t a, int32_t b) const
+    {
+        auto ca = voiceInfo.hot.voiceCounter[a], cb = voiceInfo.hot.voiceCounter[b];
+        return ca < cb || (ca == cb && a < b);
+    }
+
+    // Meld two heaps of mode m, the losing root becoming the winner's first child
+    int32_t meldStealHeaps(int32_t a, int32_t b, int m)
+    {
+        if (a < 0)
+            return b;
+        if (b < 0)
+            return a;
+        if (stealsBefore(b, a, stealModeAt(m)))
+            std::swap(a, b);
+        auto &w = voiceInfo.warm;
+        w[b].stealPrev[m] = a;
+        w[b].stealNext[m] = w[a].stealChild[m];
+        if (w[a].stealChild[m] >= 0)
+            w[w[a].stealChild[m]].stealPrev[m] = b;
+        w[a].stealChild[m] = b;
+        return a;
+    }
+
+    // Meld a sibling list into one heap: in pairs left to right, then the pairs right to left
+    int32_t meldStealSiblings(int32_t first, int m)
+    {
+        auto &w = voiceInfo.warm;
+        int32_t pairs{-1}; // the melded pairs, last first, linked through stealNext
+        while (first >= 0)
+        {
+            auto a = first, b = w[a].stealNext[m];
+            first = b >= 0 ? w[b].stealNext[m] : -1;
+            w[a].stealNext[m] = w[a].stealPrev[m] = -1;
+            if (b >= 0)
+                w[b].stealNext[m] = w[b].stealPrev[m] = -1;
+            auto ab = meldStealHeaps(a, b, m);
+            w[ab].stealNext[m] = pairs;
+            pairs = ab;
+        }
+        int32_t res{-1};
+        while (pairs >= 0)
+        {
+            auto ab = pairs;
+            pairs = w[ab].stealNext[m];
+            w[ab].stealNext[m] = -1;
+            res = meldStealHeaps(res, ab, m);
+        }
+        return res;
+    }
+
+    std::array<int32_t, stealModeCount> &stealRoots(int32_t idx)
+    {
+        return groupAt(voiceInfo.hot.polyGroupIndex[idx])
+            .stealCandidates.root[voiceInfo.warm[idx].stealGate];
+    }
+
+    void fileStealCandidate(int32_t idx)
+    {
+        auto &vi = voiceInfo.warm[idx];
+        auto &roots = stealRoots(idx);
+        for (int m = 0; m < stealModeCount; ++m)
+        {
+            vi.stealChild[m] = vi.stealNext[m] = vi.stealPrev[m] = -1;
+            roots[m] = meldStealHeaps(roots[m], idx, m);
+        }
+    }
+
+    // Cut a voice out of its heaps. Only the voice's own links are needed, so this is sound
+    // even if its key or age already changed; the rest of each heap is still in order.
+    void unfileStealCandidate(int32_t idx)
+    {
+        auto &w = voiceInfo.warm;
+        auto &vi = w[idx];
+        auto &roots = stealRoots(idx);
+        for (int m = 0; m < stealModeCount; ++m)
+        {
+            auto below = meldStealSiblings(vi.stealChild[m], m);
+            if (roots[m] == idx)
+            {
+                roots[m] = below;
+            }
+            else
+            {
+                auto prev = vi.stealPrev[m], next = vi.stealNext[m];
+                (w[prev].stealChild[m] == idx ? w[prev].stealChild[m] : w[prev].stealNext[m]) =
+                    next;
+                if (next >= 0)
+                    w[next].stealPrev[m] = prev;
+                roots[m] = meldStealHeaps(roots[m], below, m);
+            }
+            vi.stealChild[m] = vi.stealNext[m] = vi.stealPrev[m] = -1;
+        }
+    }
+
+    // Refile a voice after any change to its activity, gate, key, age or alreadyStole.
+    void syncStealCandidate(int32_t idx)
+    {
+        auto &vi = voiceInfo.warm[idx];
+        if (vi.stealGate >= 0)
+        {
+            unfileStealCandidate(idx);
+            vi.stealGate = -1;
+        }
+        if (voiceInfo.hot.activeVoiceCookie[idx] && !vi.alreadyStole)
+        {
+            vi.stealGate = (voiceInfo.hot.gated[idx] || vi.gatedDueToSustain) ? 1 : 0;
+            fileStealCandidate(idx);
+        }
+        refreshStealTree(voiceInfo.hot.polyGroupIndex[idx]);
+    }
+    void syncStealCandidate(const VoiceInfo &vi) { syncStealCandidate(vi.index); }
+
+    void markAlreadyStole(int32_t idx)
+    {
+        auto &vi = voiceInfo.warm[idx];
+        vi.alreadyStole = true;
+        if (!vi.inStolenSlots)
+        {
+            vi.inStolenSlots = true;
+            stolenSlots.push_back(idx);
+        }
+        syncStealCandidate(idx);
+    }
+
+    void clearAlreadyStole()
+    {
+        for (auto idx : stolenSlots)
+        {
+            auto &vi = voiceInfo.warm[idx];
+            vi.inStolenSlots = false;
+            if (vi.alreadyStole)
+            {
+                vi.alreadyStole = false;
+                syncStealCandidate(idx);
+            }
+        }
+        stolenSlots.clear();
+    }
+
+    // The lower slot wins among equal priorities, as a scan in slot order would find
+    bool stealsBefore(int32_t a, int32_t b, StealingPriorityMode pm) const
+    {
+        if (pm == StealingPriorityMode::OLDEST)
+            return stealAgeLess(a, b);
+        auto ka = voiceInfo.hot.key[a], kb = voiceInfo.hot.key[b];
+        if (ka != kb)
+            return pm == StealingPriorityMode::HIGHEST ? ka > kb : ka < kb;
+        return a < b;
+    }
+
+    /*
+     * The best candidate of each group's own voices sits at that group's place in the group
+     * tour, in a segment tree (leaves at [L, 2L), node i above 2i and 2i + 1) holding per node
+     * the best of its leaves for each gate and priority mode. As a steal scope's subtree is a
+     * run of the tour, its best candidate is O(log groups) nodes away however many groups it
+     * spans. L is maxGroups rounded up to a power of two and is sized once, so an appended
+     * group fills one leaf, a reparent rewrites the leaves of the run it moves, and
+     * otherwise the tree is updated a leaf at a time.
+     */
+    using StealPicks = std::array<int32_t, 2 * stealModeCount>; // [gate * modes + mode]
+    std::vector<StealPicks> stealTree{};
+    size_t stealTreeLeaves{0};
+
+    static int stealPickIndex(int gate, StealingPriorityMode pm)
+    {
+        return gate * stealModeCount + static_cast<int>(pm);
+    }
+
+    static StealingPriorityMode stealModeAt(int mi)
+    {
+        return static_cast<StealingPriorityMode>(mi % stealModeCount);
+    }
+
+    int32_t betterStealCandidate(int32_t a, int32_t b, StealingPriorityMode pm) const
     {
-        if (channel >= 0 && channel < static_cast<int16_t>(lastPBByChannel.size()))
-            lastPBByChannel[channel] = static_cast<int16_t>(pb14bit - 8192);
+        if (a < 0)
+            return b;
+        if (b < 0)
+            return a;
+        return stealsBefore(b, a, pm) ? b : a;
+    }
 
-        vm.monoResponder.setMIDIPitchBend(channel, pb14bit);
+    StealPicks ownStealPicks(int32_t g) const
+    {
+        StealPicks res;
+        const auto &root = groupAt(g).stealCandidates.root;
+        for (int i = 0; i < static_cast<int>(res.size()); ++i)
+            res[i] = root[i / stealModeCount][i % stealModeCount];
+        return res;
     }
 
-    void doMPEPitchBend(int16_t port, int16_t channel, int16_t pb14bit)
+    void combineStealPicks(size_t node)
     {
-        for (auto &vi : voiceInfo)
-        {
-            if (vi.matches(port, channel, -1, -1) &&
-                vi.gated) // all keys and notes on a channel for midi PB
-            {
-                vm.responder.setVoiceMIDIMPEChannelPitchBend(vi.activeVoiceCookie, pb14bit);
-            }
-        }
+        auto &t = stealTree[node];
+        const auto &l = stealTree[2 * node], &r = stealTree[2 * node + 1];
+        for (int i = 0; i < static_cast<int>(t.size()); ++i)
+            t[i] = betterStealCandidate(l[i], r[i], stealModeAt(i));
     }
 
-    void doMonoChannelPressure(int16_t port, int16_t channel, int8_t val)
+    void sizeStealTree()
     {
-        vm.monoResponder.setMIDIChannelPressure(channel, val);
+        stealTreeLeaves = std::bit_ceil(std::max<size_t>(maxGroups, 1));
+        StealPicks none;
+        none.fill(-1);
+        stealTree.assign(2 * stealTreeLeaves, none);
     }
 
-    void doMPEChannelPressure(int16_t port, int16_t channel, int8_t val)
+    // The groups at tour positions [lo, hi) changed; rewrite those leaves and the nodes
+    // above them, a level at a time
+    void refreshStealTreeRange(int32_t lo, int32_t hi)
     {
-        for (auto &vi : voiceInfo)
-        {
-            if (vi.activeVoiceCookie && vi.port == port && vi.channel == channel && vi.gated)
-            {
-                vm.responder.setVoiceMIDIMPEChannelPressure(vi.activeVoiceCookie, val);
-            }
-        }
+        auto l = stealTreeLeaves + static_cast<size_t>(lo);
+        auto r = stealTreeLeaves + static_cast<size_t>(hi) - 1;
+        for (auto node = l; node <= r; ++node)
+            stealTree[node] = ownStealPicks(groupTour[node - stealTreeLeaves]);
+        for (l >>= 1, r >>= 1; l >= 1; l >>= 1, r >>= 1)
+            for (auto node = l; node <= r; ++node)
+                combineStealPicks(node);
     }
 
-    void endVoice(typename Cfg::voice_t *v)
+    // Group g's own candidates changed
+    void refreshStealTree(int32_t g)
     {
-        for (auto &vi : voiceInfo)
-        {
-            if (vi.activeVoiceCookie == v)
-            {
-                adjustSubtreeUsedVoices(vi.polyGroup, -1);
-                --totalUsedVoices;
-                VML("  - Ending voice " << vi.activeVoiceCookie << " pg=" << vi.polyGroup
-                                        << " used now is " << group(vi.polyGroup).usedVoices << " ("
-                                        << totalUsedVoices << ")");
-                vi.activeVoiceCookie = nullptr;
-            }
-        }
+        auto node = stealTreeLeaves + static_cast<size_t>(groupAt(g).tourEnter);
+        stealTree[node] = ownStealPicks(g);
+        for (node >>= 1; node >= 1; node >>= 1)
+            combineStealPicks(node);
     }
 
-    int32_t findNextStealableVoiceInfo(uint64_t polygroup, StealingPriorityMode pm,
-                                       bool ignorePolygroup = false)
+    // The best candidate whose leaf group sits in scope's subtree, or anywhere for noGroup
+    int32_t bestStealCandidateInScope(int32_t scope, int gate, StealingPriorityMode pm)
     {
-        int32_t oldestGated{-1}, oldestNonGated{-1};
-        int64_t gi{std::numeric_limits<int64_t>::max()}, ngi{gi};
-        if (pm == StealingPriorityMode::HIGHEST)
+        auto n = stealTreeLeaves;
+        auto pi = stealPickIndex(gate, pm);
+        auto l = n + (scope == noGroup ? 0 : static_cast<size_t>(groupAt(scope).tourEnter));
+        auto r = n + (scope == noGroup ? groupTour.size()
+                                       : static_cast<size_t>(groupAt(scope).tourExit));
+        int32_t best{-1};
+        for (; l < r; l >>= 1, r >>= 1)
         {
-            gi = std::numeric_limits<int64_t>::min();
-            ngi = gi;
+            if (l & 1)
+                best = betterStealCandidate(best, stealTree[l++][pi], pm);
+            if (r & 1)
+                best = betterStealCandidate(best, stealTree[--r][pi], pm);
         }
+        return best;
+    }
 
+    int32_t findNextStealableVoiceInfo(int32_t polygroup, StealingPriorityMode pm,
+                                       bool ignorePolygroup = false)
+    {
         VML("- Finding stealable from " << polygroup << " with ignore " << ignorePolygroup);
 
-        for (int32_t vi = 0; vi < static_cast<int32_t>(voiceInfo.size()); ++vi)
-        {
-            const auto &v = voiceInfo[vi];
-            if (!v.activeVoiceCookie)
-            {
-                continue;
-            }
-            // polygroup is a steal *scope*: a voice is eligible when its leaf group sits
-            // in that scope's subtree (so a parent scope reaches all its descendants).
-            // ignorePolygroup keeps the GLOBAL-scope "any voice" behavior. With no
-            // hierarchy this is exactly v.polyGroup == polygroup.
-            if (!ignorePolygroup && !isDescendantOrSelf(v.polyGroup, polygroup))
-            {
-                continue;
-            }
-            if (v.alreadyStole)
-            {
-                continue;
-            }
-
-            VML("   - Considering " << vi << " " << v.key << " " << gi << " " << v.voiceCounter);
-            if (v.gated || v.gatedDueToSustain)
-            {
-                switch (pm)
-                {
-                case StealingPriorityMode::OLDEST:
-                {
-                    if (v.voiceCounter < gi)
-                    {
-                        oldestGated = vi;
-                        gi = v.voiceCounter;
-                    }
-                }
-                break;
-
-                case StealingPriorityMode::HIGHEST:
-                {
-                    if (v.key > gi)
-                    {
-                        oldestGated = vi;
-                        gi = v.key;
-                    }
-                }
-                break;
-
-                case StealingPriorityMode::LOWEST:
-                {
-                    if (v.key < gi)
-                    {
-                        oldestGated = vi;
-                        gi = v.key;
-                    }
-                }
-                break;
-                }
-            }
-            else
-            {
-                switch (pm)
-                {
-                case StealingPriorityMode::OLDEST:
-                {
-                    if (v.voiceCounter < ngi)
-                    {
-                        oldestNonGated = vi;
-                        ngi = v.voiceCounter;
-                    }
-                }
-                break;
-
-                case StealingPriorityMode::HIGHEST:
-                {
-                    if (v.key > ngi)
-                    {
-                        oldestNonGated = vi;
-                        ngi = v.key;
-                    }
-                }
-                break;
+        // polygroup is a steal *scope*: a voice is eligible when its leaf group sits in that
+        // scope's subtree (so a parent scope reaches all its descendants). With no hierarchy
+        // this is just the voices of polygroup itself. The GLOBAL scope takes any voice.
+        auto scope = ignorePolygroup ? noGroup : polygroup;
+        auto findBest = [&](int gate) { return bestStealCandidateInScope(scope, gate, pm); };
 
-                case StealingPriorityMode::LOWEST:
-                {
-                    if (v.key < ngi)
-                    {
-                        oldestNonGated = vi;
-                        ngi = v.key;
-                    }
-                }
-                break;
-                }
-            }
+        auto res = findBest(0);
+        if (res >= 0)
+        {
+            VML("  - Found (ONG) " << res);
         }
-        if (oldestNonGated >= 0)
+        else
         {
-            VML("  - Found (ONG) " << oldestGated);
-            voiceInfo[oldestNonGated].alreadyStole = true;
-            return oldestNonGated;
+            res = findBest(1);
+            if (res >= 0)
+                VML("  - Found (OG) " << res);
         }
-        if (oldestGated >= 0)
+
+        if (res < 0)
         {
-            VML("  - Found (OG) " << oldestGated);
-            voiceInfo[oldestGated].alreadyStole = true;
-            return oldestGated;
+            VML("   - FOUND NO STEALABLE VOICES");
+            return -1;
         }
-        VML("   - FOUND NO STEALABLE VOICES");
-        return -1;
+        markAlreadyStole(res);
+        return res;
     }
 
     // Steal up to `count` voices from a group's subtree (findNextStealableVoiceInfo is
-    // scope-based: any voice whose leaf isDescendantOrSelf of `group` is eligible), using
+    // scope-based: any voice whose leaf sits in the subtree of `group` is eligible), using
     // the group's stealing priority mode and keeping multi-voice notes (shared
     // transactionId) together. Counts off a local tally rather than re-reading usedVoices,
     // since under delayed termination the end callback (which decrements usedVoices) has
     // not run yet.
-    void stealVoicesFromGroup(uint64_t group, int32_t count)
+    void stealVoicesFromGroup(int32_t group, int32_t count)
     {
-        auto pm = this->group(group).stealingPriorityMode;
+        auto pm = groupAt(group).stealingPriorityMode;
         auto toSteal = count;
         auto lastToSteal = toSteal + 1;
         while (toSteal > 0 && toSteal != lastToSteal)
@@ -427,15 +2147,16 @@ struct VoiceManager<Cfg, Responder, MonoResponder>::Details
             auto idx = findNextStealableVoiceInfo(group, pm);
             if (idx >= 0)
             {
-                auto &sv = voiceInfo[idx];
+                auto sv = voiceInfo[idx];
+                gatherTransactionSiblings(idx);
                 vm.responder.terminateVoice(sv.activeVoiceCookie);
                 --toSteal;
-                for (auto &v : voiceInfo)
+                for (auto s : transactionSiblings)
                 {
-                    if (v.activeVoiceCookie && v.activeVoiceCookie != sv.activeVoiceCookie &&
-                        v.transactionId == sv.transactionId)
+                    auto v = voiceInfo[s];
+                    if (v.activeVoiceCookie && v.transactionId == sv.transactionId)
                     {
-                        v.alreadyStole = true;
+                        markAlreadyStole(s);
                         vm.responder.terminateVoice(v.activeVoiceCookie);
                         --toSteal;
                     }
@@ -444,97 +2165,29 @@ struct VoiceManager<Cfg, Responder, MonoResponder>::Details
         }
         // findNextStealableVoiceInfo marks alreadyStole; the note-on path clears it during
         // placement but we have no placement, so reset it here for the next pass.
-        for (auto &v : voiceInfo)
-            v.alreadyStole = false;
+        clearAlreadyStole();
     }
 
     using continuationData_t = typename VoiceInitInstructionsEntry<Cfg>::continuationData_t;
 
-    void doMonoRetrigger(int16_t port, uint64_t polyGroup,
+    // Mono groups to hand off to another held key once a note-off or pedal-up finishes its
+    // releases. Only groups owning a matching voice land here, so maxVoiceCount bounds them.
+    detail::FixedLinearMap<int32_t, std::optional<continuationData_t>, Cfg::maxVoiceCount>
+        noteOffRetriggerGroups{};
+    detail::FixedVector<int32_t, Cfg::maxVoiceCount> sustainRetriggerGroups{};
+
+    void doMonoRetrigger(int16_t port, int32_t gi,
                          std::optional<continuationData_t> contData = std::nullopt)
     {
+        auto polyGroup = groupAt(gi).id;
         VML("=== MONO mode voice retrigger or move for " << polyGroup);
-        auto &ks = keyStateByPort[port];
-        auto ft = group(polyGroup).playModeFeatures;
+        auto ft = groupAt(gi).playModeFeatures;
         int dch{-1}, dk{-1};
         float dvel{0.f};
 
         auto findBestKey = [&](bool ignoreSustain)
         {
-            if (ft & static_cast<uint64_t>(MonoPlayModeFeatures::ON_RELEASE_TO_LATEST))
-            {
-                int64_t mtx = 0;
-                for (int ch = 0; ch < 16; ++ch)
-                {
-                    for (int k = 0; k < 128; ++k)
-                    {
-                        auto ksp = ks[ch][k].find(polyGroup);
-                        if (ksp != ks[ch][k].end())
-                        {
-                            const auto [tx, vel, hbs] = ksp->second;
-                            if (hbs != ignoreSustain)
-                                continue;
-                            VML("- Found note " << ch << " " << k << " " << tx << " " << vel << " "
-                                                << hbs << " with ignore " << ignoreSustain);
-                            if (mtx < tx)
-                            {
-                                mtx = tx;
-                                dch = ch;
-                                dk = k;
-                                dvel = vel;
-                            }
-                        }
-                    }
-                }
-            }
-            else if (ft & static_cast<uint64_t>(MonoPlayModeFeatures::ON_RELEASE_TO_HIGHEST))
-            {
-                int64_t mk = 0;
-                for (int ch = 0; ch < 16; ++ch)
-                {
-                    for (int k = 0; k < 128; ++k)
-                    {
-                        auto ksp = ks[ch][k].find(polyGroup);
-                        if (ksp != ks[ch][k].end())
-                        {
-                            const auto [tx, vel, hbs] = ksp->second;
-                            if (hbs != ignoreSustain)
-                                continue;
-                            if (tx != 0 && k > mk)
-                            {
-                                mk = k;
-                                dch = ch;
-                                dk = k;
-                                dvel = vel;
-                            }
-                        }
-                    }
-                }
-            }
-            else if (ft & static_cast<uint64_t>(MonoPlayModeFeatures::ON_RELEASE_TO_LOWEST))
-            {
-                int64_t mk = 1024;
-                for (int ch = 0; ch < 16; ++ch)
-                {
-                    for (int k = 0; k < 128; ++k)
-                    {
-                        auto ksp = ks[ch][k].find(polyGroup);
-                        if (ksp != ks[ch][k].end())
-                        {
-                            const auto [tx, vel, hbs] = ksp->second;
-                            if (hbs != ignoreSustain)
-                                continue;
-                            if (tx != 0 && k < mk)
-                            {
-                                mk = k;
-                                dch = ch;
-                                dk = k;
-                                dvel = vel;
-                            }
-                        }
-                    }
-                }
-            }
+            findBestHeldKey(port, polyGroup, ft, ignoreSustain, dch, dk, dvel);
             VML("- FindBestKey Result is " << dch << "/" << dk);
         };
 
@@ -575,43 +2228,46 @@ struct VoiceManager<Cfg, Responder, MonoResponder>::Details
             while (!voiceInitWorkingBuffer[idx].voice)
                 idx++;
 
-            for (auto &vi : voiceInfo)
+            while (voicesLeft > 0)
             {
-                if (!vi.activeVoiceCookie)
+                auto slot = findFreeVoiceSlot();
+                if (slot < 0)
+                    break;
+
+                auto vi = voiceInfo[slot];
+                vi.voiceCounter = mostRecentVoiceCounter++;
+                vi.transactionId = mostRecentTransactionID;
+                vi.port = port;
+                vi.channel = dch;
+                vi.key = dk;
+                vi.setNoteId(dnid);
+                vi.resetNoteIdStack(dnid);
+                vi.setVoiceId(dnid);
+                vi.alreadyStole = false;
+                vi.snapOriginalToCurrent();
+
+                vi.gated = true;
+                vi.gatedDueToSustain = false;
+                vi.activeVoiceCookie = voiceInitWorkingBuffer[idx].voice;
+                vi.polyGroup = voiceBeginWorkingBuffer[idx].polyphonyGroup;
+                vi.polyGroupIndex = gi; // every other begin entry was skipped
+
+                recordKeyState(vi.port, vi.channel, vi.key, gi, vi.transactionId, dvel);
+
+                VML("- New Voice assigned with "
+                    << mostRecentVoiceCounter << " at pckn=" << port << "/" << dch << "/" << dk
+                    << "/" << dnid << " pg=" << vi.polyGroup);
+
+                activateVoiceSlot(slot);
+
+                --voicesLeft;
+                if (voicesLeft == 0)
                 {
-                    vi.voiceCounter = mostRecentVoiceCounter++;
-                    vi.transactionId = mostRecentTransactionID;
-                    vi.port = port;
-                    vi.channel = dch;
-                    vi.key = dk;
-                    vi.noteId = dnid;
-                    vi.alreadyStole = false;
-                    vi.snapOriginalToCurrent();
-
-                    vi.gated = true;
-                    vi.gatedDueToSustain = false;
-                    vi.activeVoiceCookie = voiceInitWorkingBuffer[idx].voice;
-                    vi.polyGroup = voiceBeginWorkingBuffer[idx].polyphonyGroup;
-
-                    keyStateByPort[vi.port][vi.channel][vi.key][vi.polyGroup] = {vi.transactionId,
-                                                                                 dvel};
-
-                    VML("- New Voice assigned with "
-                        << mostRecentVoiceCounter << " at pckn=" << port << "/" << dch << "/" << dk
-                        << "/" << dnid << " pg=" << vi.polyGroup);
-
-                    adjustSubtreeUsedVoices(vi.polyGroup, 1);
-                    ++totalUsedVoices;
-
-                    --voicesLeft;
-                    if (voicesLeft == 0)
-                    {
-                        break;
-                    }
-                    idx++;
-                    while (!voiceInitWorkingBuffer[idx].voice)
-                        idx++;
+                    break;
                 }
+                idx++;
+                while (!voiceInitWorkingBuffer[idx].voice)
+                    idx++;
             }
 
             vm.responder.endVoiceCreationTransaction(port, dch, dk, dnid, dvel);
@@ -621,10 +2277,11 @@ struct VoiceManager<Cfg, Responder, MonoResponder>::Details
                  dk >= 0)
         {
             VML("- Move notes in group " << polyGroup << " to " << dch << "/" << dk);
-            for (auto &v : voiceInfo)
-            {
-                if (v.activeVoiceCookie && v.polyGroup == polyGroup)
+            forEachVoiceInGroupBySlot(
+                gi,
+                [&](auto vidx)
                 {
+                    auto v = voiceInfo[vidx];
                     if (v.gated || v.gatedDueToSustain)
                     {
                         VML("- Move gated voice");
@@ -639,30 +2296,35 @@ struct VoiceManager<Cfg, Responder, MonoResponder>::Details
                     v.port = port;
                     v.channel = dch;
                     v.key = dk;
-                }
-            }
+                    syncStealCandidate(v);
+                    syncVoiceKey(vidx);
+                });
         }
     }
 
     bool anyKeyHeldFor(int16_t port, uint64_t polyGroup, int exceptChannel, int exceptKey,
                        bool includeHeldBySustain = false)
     {
-        auto &ks = keyStateByPort[port];
-        for (int ch = 0; ch < 16; ++ch)
+        auto *mh = monoHeldKeys.find({port, -1, -1, polyGroup});
+        if (!mh)
+            return false;
+
+        // Held counts less the excepted key, if it is among the keys counted
+        auto held = mh->count[0] + (includeHeldBySustain ? mh->count[1] : 0);
+        if (held > 0 && isInKeyRange(exceptChannel, exceptKey))
         {
-            for (int k = 0; k < 128; ++k)
+            auto *bits = monoHeldKeyBits.find(
+                {port, static_cast<int16_t>(exceptChannel), -1, polyGroup});
+            if (bits)
             {
-                auto ksp = ks[ch][k].find(polyGroup);
-                if (ksp != ks[ch][k].end() && (includeHeldBySustain || !ksp->second.heldBySustain))
-                {
-                    if (!(ch == exceptChannel && k == exceptKey))
-                    {
-                        return true;
-                    }
-                }
+                auto w = exceptKey >> 6;
+                auto b = 1ULL << (exceptKey & 63);
+                held -= ((*bits)[0][w] & b) ? 1 : 0;
+                if (includeHeldBySustain)
+                    held -= ((*bits)[1][w] & b) ? 1 : 0;
             }
         }
-        return false;
+        return held > 0;
     }
 
     void debugDumpKeyState(int port) const
@@ -670,24 +2332,16 @@ struct VoiceManager<Cfg, Responder, MonoResponder>::Details
         if constexpr (vmLog)
         {
             VML(">>>> Dump Key State " << port);
-            auto &ks = keyStateByPort.at(port);
-            for (int ch = 0; ch < 16; ++ch)
-            {
-                for (int k = 0; k < 128; ++k)
+            keyStates.forEach(
+                [&](const auto &k, auto n)
                 {
-                    if (!ks[ch][k].empty())
-                    {
-                        VML(">>>> - State at " << ch << "/" << k);
-                        auto &vmap = ks[ch][k];
-                        for (const auto &[pg, it] : vmap)
-                        {
-                            VML(">>>>   - PG=" << pg);
-                            VML(">>>>     " << it.transaction << "/" << it.inceptionVelocity << "/"
-                                            << it.heldBySustain);
-                        }
-                    }
-                }
-            }
+                    if (k.port != port)
+                        return;
+                    const auto &it = heldKeyNodes[n].state;
+                    VML(">>>> - State at " << k.channel << "/" << k.key << " PG=" << k.polyGroup);
+                    VML(">>>>     " << it.transaction << "/" << it.inceptionVelocity << "/"
+                                    << it.heldBySustain);
+                });
             VML("<<<< Dump Key State");
         }
     }
@@ -716,6 +2370,8 @@ bool VoiceManager<Cfg, Responder, MonoResponder>::processNoteOnEvent(int16_t por
                                                                      int16_t key, int32_t noteid,
                                                                      float velocity, float retune)
 {
+    details.flushCoalescedControllers(channel, details.eventSampleOffset);
+
     if (channel >= 0 && channel < 16 && key >= 0 && key < 128)
         heldMIDIKeyByChannel[channel][key] = true;
 
@@ -723,8 +2379,10 @@ bool VoiceManager<Cfg, Responder, MonoResponder>::processNoteOnEvent(int16_t por
     {
         bool didAnyRetrigger{false};
         ++details.mostRecentTransactionID;
-        for (auto &vi : details.voiceInfo)
+        auto hits = details.matchingVoiceSlots(port, channel, key);
+        for (auto idx : detail::SetBits{hits})
         {
+            auto vi = details.voiceInfo[idx];
             if (vi.matches(port, channel, key, -1)) // dont match noteid
             {
                 /*
@@ -745,18 +2403,20 @@ bool VoiceManager<Cfg, Responder, MonoResponder>::processNoteOnEvent(int16_t por
                 // If we release we will turn gatedDueToSustain back on
                 vi.gatedDueToSustain = false;
                 vi.voiceCounter = ++details.mostRecentVoiceCounter;
+                auto vidx = vi.index;
+                details.leaveTransaction(vidx);
                 vi.transactionId = details.mostRecentTransactionID;
-                vi.noteIdStack[vi.noteIdStackPos] = noteid;
-                vi.noteIdStackPos =
-                    (vi.noteIdStackPos + 1) & (Details::VoiceInfo::noteIdStackSize - 1);
+                details.joinCurrentTransaction(vidx);
+                vi.pushNoteId(noteid);
 
                 // if both legs have note ids then only do one voice
                 auto hadNoteId = vi.noteId != -1;
                 auto hasNoteId = noteid != -1;
 
-                vi.noteId = noteid;
-                vi.voiceId = noteid;
+                vi.setNoteId(noteid);
+                vi.setVoiceId(noteid);
                 vi.alreadyStole = false;
+                details.syncStealCandidate(vi);
 
                 if (hadNoteId && hasNoteId)
                 {
@@ -783,18 +2443,27 @@ bool VoiceManager<Cfg, Responder, MonoResponder>::processNoteOnEvent(int16_t por
         return true;
     }
 
-    std::unordered_map<uint64_t, int32_t> createdByPolyGroup;
-    std::unordered_set<uint64_t> monoGroups;
+    auto &createdByPolyGroup = details.createdByPolyGroup;
+    auto &monoGroups = details.monoGroups;
+    createdByPolyGroup.clear();
+    monoGroups.clear();
+    auto &beginGroupIndex = details.voiceBeginGroupIndex;
     for (int i = 0; i < voicesToBeLaunched; ++i)
     {
-        assert(details.groups.find(details.voiceBeginWorkingBuffer[i].polyphonyGroup) !=
-               details.groups.end());
-
-        ++createdByPolyGroup[details.voiceBeginWorkingBuffer[i].polyphonyGroup];
-        if (details.group(details.voiceBeginWorkingBuffer[i].polyphonyGroup).playMode ==
-            PlayMode::MONO_NOTES)
+        auto gi = details.groupIndex(details.voiceBeginWorkingBuffer[i].polyphonyGroup);
+        // A responder naming a group it never guaranteed plays in the default group rather
+        // than have note-on allocate one for it
+        if (gi == Details::noGroup)
+        {
+            VML("- Group " << details.voiceBeginWorkingBuffer[i].polyphonyGroup
+                           << " never guaranteed; using the default group");
+            gi = Details::defaultGroup;
+        }
+        beginGroupIndex[i] = gi;
+        ++createdByPolyGroup[gi];
+        if (details.groupAt(gi).playMode == PlayMode::MONO_NOTES)
         {
-            monoGroups.insert(details.voiceBeginWorkingBuffer[i].polyphonyGroup);
+            monoGroups.insertUnique(gi);
         }
     }
 
@@ -804,11 +2473,8 @@ bool VoiceManager<Cfg, Responder, MonoResponder>::processNoteOnEvent(int16_t por
     for (int i = 0; i < voicesToBeLaunched; ++i)
     {
         details.voiceInitInstructionsBuffer[i] = {};
-        const auto &vbb = details.voiceBeginWorkingBuffer[i];
-        auto polyGroup = vbb.polyphonyGroup;
-        assert(details.groups.find(polyGroup) != details.groups.end());
-
-        auto pm = details.group(polyGroup).playMode;
+        auto polyGroup = beginGroupIndex[i];
+        auto pm = details.groupAt(polyGroup).playMode;
         if (pm == PlayMode::MONO_NOTES)
             continue;
 
@@ -819,33 +2485,20 @@ bool VoiceManager<Cfg, Responder, MonoResponder>::processNoteOnEvent(int16_t por
         // Free voices is the min over polyGroup's whole ancestor chain and the global
         // pool. The steal scope is the deepest full level on that chain (the global pool
         // is the topmost level): a voice in its subtree decrements it and every shallower
-        // full ancestor at once, while a leaf below it is left free to grow.
+        // full ancestor at once, while a leaf below it is left free to grow. The chain's
+        // part is cached, so only the global pool is folded in here.
+        auto budget = details.chainBudget(polyGroup);
         int32_t globalFreeVoices = Cfg::maxVoiceCount - details.totalUsedVoices;
-        int32_t voicesFree = globalFreeVoices;
-        uint64_t stealScope{polyGroup};
-        bool stealGlobal{false};
-        bool foundFull{false};
-        for (uint64_t g = polyGroup; g != noPolyphonyGroupParent; g = details.group(g).parentGroup)
-        {
-            // Raw free can go negative under delayed termination (usedVoices outruns the
-            // limit until the end callback fires); clamp for the budget min but keep the
-            // raw sign to detect a full level.
-            int32_t gFreeRaw = details.group(g).polyLimit - details.group(g).usedVoices;
-            voicesFree = std::min(voicesFree, std::max(0, gFreeRaw));
-            if (gFreeRaw <= 0 && !foundFull)
-            {
-                stealScope = g;
-                foundFull = true;
-            }
-        }
-        if (!foundFull && globalFreeVoices <= 0)
-            stealGlobal = true;
+        int32_t voicesFree = std::min(globalFreeVoices, budget.free);
+        bool foundFull = budget.deepestFull != Details::noGroup;
+        auto stealScope = foundFull ? budget.deepestFull : polyGroup;
+        bool stealGlobal = !foundFull && globalFreeVoices <= 0;
 
-        VML("- VoicesFree=" << voicesFree << " toBeCreated=" << createdByPolyGroup.at(polyGroup)
+        VML("- VoicesFree=" << voicesFree << " toBeCreated=" << createdByPolyGroup[polyGroup]
                             << " stealScope=" << stealScope << " stealGlobal=" << stealGlobal
                             << " globalFreeVoices=" << globalFreeVoices);
 
-        auto voicesToSteal = std::max(createdByPolyGroup.at(polyGroup) - voicesFree, 0);
+        auto voicesToSteal = std::max(createdByPolyGroup[polyGroup] - voicesFree, 0);
 
         VML("- Voices to steal is " << voicesToSteal);
         auto lastVoicesToSteal = voicesToSteal + 1;
@@ -855,12 +2508,13 @@ bool VoiceManager<Cfg, Responder, MonoResponder>::processNoteOnEvent(int16_t por
             // Priority mode is the triggering leaf's, even when the steal scope is an
             // ancestor (decision #1); we may switch to group(stealScope)'s mode later.
             auto stealVoiceIndex = details.findNextStealableVoiceInfo(
-                stealScope, details.group(polyGroup).stealingPriorityMode, stealGlobal);
+                stealScope, details.groupAt(polyGroup).stealingPriorityMode, stealGlobal);
             VML("- " << voicesToSteal << " from " << stealScope << " stealing voice "
                      << stealVoiceIndex);
             if (stealVoiceIndex >= 0)
             {
-                auto &stealVoice = details.voiceInfo[stealVoiceIndex];
+                auto stealVoice = details.voiceInfo[stealVoiceIndex];
+                details.gatherTransactionSiblings(stealVoiceIndex);
                 responder.terminateVoice(stealVoice.activeVoiceCookie);
                 VML("  - SkipThis found");
                 --voicesToSteal;
@@ -869,11 +2523,10 @@ bool VoiceManager<Cfg, Responder, MonoResponder>::processNoteOnEvent(int16_t por
                  * This code makes sure if voices were launched from the same
                  * event they are reaped together
                  */
-                for (const auto &v : details.voiceInfo)
+                for (auto s : details.transactionSiblings)
                 {
-                    if (v.activeVoiceCookie &&
-                        v.activeVoiceCookie != stealVoice.activeVoiceCookie &&
-                        v.transactionId == stealVoice.transactionId)
+                    const auto v = details.voiceInfo[s];
+                    if (v.activeVoiceCookie && v.transactionId == stealVoice.transactionId)
                     {
                         responder.terminateVoice(v.activeVoiceCookie);
                         --voicesToSteal;
@@ -889,16 +2542,17 @@ bool VoiceManager<Cfg, Responder, MonoResponder>::processNoteOnEvent(int16_t por
     for (const auto &mpg : monoGroups)
     {
         VML("- Would steal all voices in " << mpg);
-        auto isLegato = details.group(mpg).playModeFeatures &
+        auto isLegato = details.groupAt(mpg).playModeFeatures &
                         static_cast<uint64_t>(MonoPlayModeFeatures::MONO_LEGATO);
         VML("- IsLegato : " << isLegato);
         if (isLegato)
         {
             bool foundOne{false};
-            for (auto &v : details.voiceInfo)
-            {
-                if (v.activeVoiceCookie && v.polyGroup == mpg)
+            details.forEachVoiceInGroupBySlot(
+                mpg,
+                [&](auto vidx)
                 {
+                    auto v = details.voiceInfo[vidx];
                     VML("  - Moving existing voice " << &v << " " << v.activeVoiceCookie << " to "
                                                      << key << " (" << v.gated << ")");
 
@@ -907,7 +2561,7 @@ bool VoiceManager<Cfg, Responder, MonoResponder>::processNoteOnEvent(int16_t por
                     // higher than the currently playing key; LOWEST only wins if lower.
                     // If the existing voice is no longer gated (releasing), it cannot
                     // block the new note regardless of priority mode.
-                    auto mpm = details.group(mpg).monoPriorityMode;
+                    auto mpm = details.groupAt(mpg).monoPriorityMode;
                     bool newNoteWins = true;
                     if (v.gated)
                     {
@@ -929,26 +2583,26 @@ bool VoiceManager<Cfg, Responder, MonoResponder>::processNoteOnEvent(int16_t por
                                                             velocity);
                         }
 
-                        v.noteIdStack[v.noteIdStackPos] = noteid;
-                        v.noteIdStackPos =
-                            (v.noteIdStackPos + 1) & (Details::VoiceInfo::noteIdStackSize - 1);
-                        v.noteId = noteid;
+                        v.pushNoteId(noteid);
+                        v.setNoteId(noteid);
                         v.port = port;
                         v.channel = channel;
                         v.key = key;
+                        details.syncVoiceKey(v.index);
                         v.gated = true;
+                        details.syncStealCandidate(v);
                     }
 
                     // Whether or not the voice moved, no new voice is created for this note.
                     responder.discardHostVoice(noteid);
                     foundOne = true;
-                }
-            }
+                });
+
             if (foundOne)
             {
                 for (int i = 0; i < voicesToBeLaunched; ++i)
                 {
-                    if (details.voiceBeginWorkingBuffer[i].polyphonyGroup == mpg)
+                    if (beginGroupIndex[i] == mpg)
                     {
                         VML("  - Setting instruction " << i << " to skip " << mpg);
                         details.voiceInitInstructionsBuffer[i].instruction =
@@ -965,15 +2619,16 @@ bool VoiceManager<Cfg, Responder, MonoResponder>::processNoteOnEvent(int16_t por
             // new note regardless of priority mode.
             bool checkedPriority{false};
             bool newNoteWins{true};
-            for (const auto &v : details.voiceInfo)
-            {
-                if (v.activeVoiceCookie && v.polyGroup == mpg)
+            details.forEachVoiceInGroupBySlot(
+                mpg,
+                [&](auto vidx)
                 {
+                    const auto v = details.voiceInfo[vidx];
                     if (!checkedPriority)
                     {
                         if (v.gated)
                         {
-                            auto mpm = details.group(mpg).monoPriorityMode;
+                            auto mpm = details.groupAt(mpg).monoPriorityMode;
                             if (mpm == MonoPriorityMode::HIGHEST)
                                 newNoteWins = (key >= v.key);
                             else if (mpm == MonoPriorityMode::LOWEST)
@@ -988,7 +2643,7 @@ bool VoiceManager<Cfg, Responder, MonoResponder>::processNoteOnEvent(int16_t por
                         // Populate continuation data on the matching instruction entry
                         for (int i = 0; i < voicesToBeLaunched; ++i)
                         {
-                            if (details.voiceBeginWorkingBuffer[i].polyphonyGroup == mpg)
+                            if (beginGroupIndex[i] == mpg)
                             {
                                 if constexpr (HasVoiceContinuationData<Cfg>)
                                 {
@@ -1005,15 +2660,14 @@ bool VoiceManager<Cfg, Responder, MonoResponder>::processNoteOnEvent(int16_t por
                         }
                         responder.terminateVoice(v.activeVoiceCookie);
                     }
-                }
-            }
+                });
 
             if (checkedPriority && !newNoteWins)
             {
                 // New note doesn't win — keep the existing voice and skip new voice creation.
                 for (int i = 0; i < voicesToBeLaunched; ++i)
                 {
-                    if (details.voiceBeginWorkingBuffer[i].polyphonyGroup == mpg)
+                    if (beginGroupIndex[i] == mpg)
                     {
                         details.voiceInitInstructionsBuffer[i].instruction =
                             VoiceInitInstructionsEntry<Cfg>::Instruction::SKIP;
@@ -1067,9 +2721,8 @@ bool VoiceManager<Cfg, Responder, MonoResponder>::processNoteOnEvent(int16_t por
         for (int i = 0; i < voicesToBeLaunched; ++i)
         {
             // bail but still record the key press
-            details.keyStateByPort[port][channel][key]
-                                  [details.voiceBeginWorkingBuffer[i].polyphonyGroup] = {
-                details.mostRecentTransactionID, velocity};
+            details.recordKeyState(port, channel, key, beginGroupIndex[i],
+                                   details.mostRecentTransactionID, velocity);
         }
 
         responder.endVoiceCreationTransaction(port, channel, key, noteid, velocity);
@@ -1082,46 +2735,41 @@ bool VoiceManager<Cfg, Responder, MonoResponder>::processNoteOnEvent(int16_t por
 
     auto placeVoiceFromIndex = [&](int index)
     {
-        for (auto &vi : details.voiceInfo)
-        {
-            if (!vi.activeVoiceCookie)
-            {
-                vi.voiceCounter = details.mostRecentVoiceCounter++;
-                vi.transactionId = details.mostRecentTransactionID;
-                vi.port = port;
-                vi.channel = channel;
-                vi.key = key;
-                vi.noteId = noteid;
-                vi.snapOriginalToCurrent();
-
-                vi.gated = true;
-                vi.gatedDueToSustain = false;
-                vi.activeVoiceCookie = details.voiceInitWorkingBuffer[index].voice;
-                vi.polyGroup = details.voiceBeginWorkingBuffer[index].polyphonyGroup;
-                vi.noteIdStackPos = 1;
-                vi.noteIdStack[0] = noteid;
-                vi.voiceId = noteid;
-                vi.alreadyStole = false;
-
-                VML("- New Voice assigned from "
-                    << index << " with " << details.mostRecentVoiceCounter << " at pckn=" << port
-                    << "/" << channel << "/" << key << "/" << noteid << " pg=" << vi.polyGroup
-                    << " avc=" << vi.activeVoiceCookie);
-
-                assert(details.groups.find(vi.polyGroup) != details.groups.end());
-                details.adjustSubtreeUsedVoices(vi.polyGroup, 1);
-                ++details.totalUsedVoices;
-                return true;
-            }
-        }
-        return false;
+        auto slot = details.findFreeVoiceSlot();
+        if (slot < 0)
+            return false;
+
+        auto vi = details.voiceInfo[slot];
+        vi.voiceCounter = details.mostRecentVoiceCounter++;
+        vi.transactionId = details.mostRecentTransactionID;
+        vi.port = port;
+        vi.channel = channel;
+        vi.key = key;
+        vi.setNoteId(noteid);
+        vi.snapOriginalToCurrent();
+
+        vi.gated = true;
+        vi.gatedDueToSustain = false;
+        vi.activeVoiceCookie = details.voiceInitWorkingBuffer[index].voice;
+        vi.polyGroup = details.voiceBeginWorkingBuffer[index].polyphonyGroup;
+        vi.polyGroupIndex = beginGroupIndex[index];
+        vi.resetNoteIdStack(noteid);
+        vi.setVoiceId(noteid);
+        vi.alreadyStole = false;
+
+        VML("- New Voice assigned from " << index << " with " << details.mostRecentVoiceCounter
+                                         << " at pckn=" << port << "/" << channel << "/" << key
+                                         << "/" << noteid << " pg=" << vi.polyGroup
+                                         << " avc=" << vi.activeVoiceCookie);
+
+        details.activateVoiceSlot(slot);
+        return true;
     };
 
     for (int i = 0; i < voicesToBeLaunched; ++i)
     {
-        details.keyStateByPort[port][channel][key]
-                              [details.voiceBeginWorkingBuffer[i].polyphonyGroup] = {
-            details.mostRecentTransactionID, velocity};
+        details.recordKeyState(port, channel, key, beginGroupIndex[i],
+                               details.mostRecentTransactionID, velocity);
 
         if (details.voiceInitInstructionsBuffer[i].instruction !=
                 VoiceInitInstructionsEntry<Cfg>::Instruction::SKIP &&
@@ -1144,23 +2792,27 @@ void VoiceManager<Cfg, Responder, MonoResponder>::processNoteOffEvent(int16_t po
                                                                       int16_t key, int32_t noteid,
                                                                       float velocity)
 {
+    details.flushCoalescedControllers(channel, details.eventSampleOffset);
+
     if (channel >= 0 && channel < 16 && key >= 0 && key < 128)
         heldMIDIKeyByChannel[channel][key] = false;
 
-    std::unordered_map<uint64_t, std::optional<typename Details::continuationData_t>>
-        retriggerGroups;
+    auto &retriggerGroups = details.noteOffRetriggerGroups;
+    retriggerGroups.clear();
 
     VML("==== PROCESS NOTE OFF " << port << "/" << channel << "/" << key << "/" << noteid << " @ "
                                  << velocity);
-    for (auto &vi : details.voiceInfo)
+    auto hits = details.matchingVoiceSlots(port, channel, key, noteid);
+    for (auto idx : detail::SetBits{hits})
     {
-        if (vi.matches(port, channel, key, noteid))
+        if (details.voiceMatches(idx, port, channel, key, noteid))
         {
+            auto vi = details.voiceInfo[idx];
             VML("- Found matching release note at " << vi.polyGroup << " " << vi.key << " "
                                                     << vi.gated);
-            if (details.group(vi.polyGroup).playMode == PlayMode::MONO_NOTES)
+            if (details.groupAt(vi.polyGroupIndex).playMode == PlayMode::MONO_NOTES)
             {
-                if (details.group(vi.polyGroup).playModeFeatures &
+                if (details.groupAt(vi.polyGroupIndex).playModeFeatures &
                     static_cast<uint64_t>(MonoPlayModeFeatures::MONO_LEGATO))
                 {
                     bool anyOtherOption = details.anyKeyHeldFor(port, vi.polyGroup, channel, key);
@@ -1170,27 +2822,16 @@ void VoiceManager<Cfg, Responder, MonoResponder>::processNoteOffEvent(int16_t po
                     if (anyOtherOption)
                     {
                         if constexpr (HasVoiceContinuationData<Cfg>)
-                            retriggerGroups[vi.polyGroup] =
+                            retriggerGroups[vi.polyGroupIndex] =
                                 responder.getContinuationData(vi.activeVoiceCookie);
                         else
-                            retriggerGroups[vi.polyGroup] = std::nullopt;
+                            retriggerGroups[vi.polyGroupIndex] = std::nullopt;
                         VML("- A key is down in same group. Initiating mono legato move");
                         continue;
                     }
                     else
                     {
-                        auto &ks = details.keyStateByPort[port];
-                        for (int ch = 0; ch < 16; ++ch)
-                        {
-                            for (int k = 0; k < 128; ++k)
-                            {
-                                for (const auto &[g, s] : ks[ch][k])
-                                {
-                                    VML("=== Held Key " << g << " " << s.transaction
-                                                        << " at k=" << (int)k << " ch=" << (int)ch)
-                                }
-                            }
-                        }
+                        details.debugDumpKeyState(port);
                     }
                 }
                 auto susCh = dialect == MIDI1Dialect::MIDI1_MPE ? mpeGlobalChannel : channel;
@@ -1204,17 +2845,19 @@ void VoiceManager<Cfg, Responder, MonoResponder>::processNoteOffEvent(int16_t po
                     {
                         VML("- There's a gated key away so untrigger this");
                         if constexpr (HasVoiceContinuationData<Cfg>)
-                            retriggerGroups[vi.polyGroup] =
+                            retriggerGroups[vi.polyGroupIndex] =
                                 responder.getContinuationData(vi.activeVoiceCookie);
                         else
-                            retriggerGroups[vi.polyGroup] = std::nullopt;
+                            retriggerGroups[vi.polyGroupIndex] = std::nullopt;
                         responder.terminateVoice(vi.activeVoiceCookie);
                         VML("- Gated to False ***");
                         vi.gated = false;
+                        details.syncStealCandidate(vi);
                     }
                     else
                     {
                         vi.gatedDueToSustain = true;
+                        details.syncStealCandidate(vi);
                     }
                 }
                 else
@@ -1228,10 +2871,10 @@ void VoiceManager<Cfg, Responder, MonoResponder>::processNoteOffEvent(int16_t po
                             VML("- Hard Terminate voice with other away " << vi.polyGroup << " "
                                                                           << vi.activeVoiceCookie);
                             if constexpr (HasVoiceContinuationData<Cfg>)
-                                retriggerGroups[vi.polyGroup] =
+                                retriggerGroups[vi.polyGroupIndex] =
                                     responder.getContinuationData(vi.activeVoiceCookie);
                             else
-                                retriggerGroups[vi.polyGroup] = std::nullopt;
+                                retriggerGroups[vi.polyGroupIndex] = std::nullopt;
                             responder.terminateVoice(vi.activeVoiceCookie);
                         }
                         else
@@ -1242,6 +2885,7 @@ void VoiceManager<Cfg, Responder, MonoResponder>::processNoteOffEvent(int16_t po
                         }
                         VML("- Gated to False ***");
                         vi.gated = false;
+                        details.syncStealCandidate(vi);
                     }
                 }
             }
@@ -1252,6 +2896,7 @@ void VoiceManager<Cfg, Responder, MonoResponder>::processNoteOffEvent(int16_t po
                 if (details.sustainOn[susCh])
                 {
                     vi.gatedDueToSustain = true;
+                    details.syncStealCandidate(vi);
                 }
                 else
                 {
@@ -1260,6 +2905,7 @@ void VoiceManager<Cfg, Responder, MonoResponder>::processNoteOffEvent(int16_t po
                         responder.releaseVoice(vi.activeVoiceCookie, velocity);
                         VML("- Gated to False ***");
                         vi.gated = false;
+                        details.syncStealCandidate(vi);
                     }
                 }
             }
@@ -1270,15 +2916,12 @@ void VoiceManager<Cfg, Responder, MonoResponder>::processNoteOffEvent(int16_t po
     if (details.sustainOn[susCh])
     {
         VML("- Updating just-by-sustain at " << port << " " << channel << " " << key);
-        for (auto &inf : details.keyStateByPort[port][channel][key])
-        {
-            inf.second.heldBySustain = true;
-        }
+        details.markKeyHeldBySustain(port, channel, key);
     }
     else
     {
-        VML("-  Clearing keyStateByPort at " << port << " " << channel << " " << key);
-        details.keyStateByPort[port][channel][key] = {};
+        VML("-  Clearing key state at " << port << " " << channel << " " << key);
+        details.clearKeyState(port, channel, key);
     }
 
     details.debugDumpKeyState(port);
@@ -1289,13 +2932,13 @@ void VoiceManager<Cfg, Responder, MonoResponder>::processNoteOffEvent(int16_t po
         details.doMonoRetrigger(port, rtg, contData);
         if (noteid >= 0)
         {
-            for (auto &vi : details.voiceInfo)
-            {
-                if (vi.polyGroup == rtg && vi.activeVoiceCookie)
+            details.forEachVoiceInGroup(
+                rtg,
+                [&](auto vidx)
                 {
+                    auto vi = details.voiceInfo[vidx];
                     vi.removeNoteIdFromStack(noteid);
-                }
-            }
+                });
         }
     }
 }
@@ -1304,6 +2947,8 @@ template <typename Cfg, typename Responder, typename MonoResponder>
 void VoiceManager<Cfg, Responder, MonoResponder>::updateSustainPedal(int16_t port, int16_t channel,
                                                                      int8_t level)
 {
+    details.flushCoalescedControllers(channel, details.eventSampleOffset);
+
     auto sop = details.sustainOn[channel];
     details.sustainOn[channel] = level > 64;
     if (sop != details.sustainOn[channel])
@@ -1312,47 +2957,41 @@ void VoiceManager<Cfg, Responder, MonoResponder>::updateSustainPedal(int16_t por
         {
             VML("Sustain Release");
             auto channelMatch = dialect == MIDI1Dialect::MIDI1_MPE ? -1 : channel;
-            std::unordered_set<uint64_t> retriggerGroups;
+            auto &retriggerGroups = details.sustainRetriggerGroups;
+            retriggerGroups.clear();
             // release all voices with sustain gates
-            for (auto &vi : details.voiceInfo)
+            auto &hot = details.voiceInfo.hot;
+            auto &warm = details.voiceInfo.warm;
+            auto active = details.activeVoiceSlots();
+            for (auto idx : detail::SetBits{active})
             {
-                if (!vi.activeVoiceCookie)
-                    continue;
-
-                VML("- Checking " << vi.gated << " " << vi.gatedDueToSustain << " " << vi.key);
-                if (vi.gatedDueToSustain && vi.matches(port, channelMatch, -1, -1))
+                VML("- Checking " << hot.gated[idx] << " " << warm[idx].gatedDueToSustain << " "
+                                  << hot.key[idx]);
+                if (warm[idx].gatedDueToSustain &&
+                    details.voiceMatches(idx, port, channelMatch, -1, -1))
                 {
-                    if (details.group(vi.polyGroup).playMode == PlayMode::MONO_NOTES)
+                    if (details.groupAt(hot.polyGroupIndex[idx]).playMode ==
+                        PlayMode::MONO_NOTES)
                     {
-                        retriggerGroups.insert(vi.polyGroup);
-                        responder.releaseVoice(vi.activeVoiceCookie, 0);
+                        retriggerGroups.insertUnique(hot.polyGroupIndex[idx]);
+                        responder.releaseVoice(hot.activeVoiceCookie[idx], 0);
                     }
                     else
                     {
-                        responder.releaseVoice(vi.activeVoiceCookie, 0);
+                        responder.releaseVoice(hot.activeVoiceCookie[idx], 0);
                     }
 
-                    details.keyStateByPort[vi.port][vi.channel][vi.key] = {};
+                    details.clearKeyState(hot.port[idx], hot.channel[idx], hot.key[idx]);
 
                     VML("- Gated to False ***");
-                    vi.gated = false;
-                    vi.gatedDueToSustain = false;
+                    hot.gated[idx] = false;
+                    warm[idx].gatedDueToSustain = false;
+                    details.syncStealCandidate(idx);
                 }
             }
             for (const auto &rtg : retriggerGroups)
             {
-                auto &ks = details.keyStateByPort[port];
-                for (int ch = 0; ch < 16; ++ch)
-                {
-                    for (int k = 0; k < 128; ++k)
-                    {
-                        auto ksp = ks[ch][k].find(rtg);
-                        if (ksp != ks[ch][k].end() && ksp->second.heldBySustain)
-                        {
-                            ks[ch][k].erase(ksp);
-                        }
-                    }
-                }
+                details.clearKeysHeldBySustain(port, details.groupAt(rtg).id);
 
                 details.doMonoRetrigger(port, rtg);
             }
@@ -1364,35 +3003,26 @@ template <typename Cfg, typename Responder, typename MonoResponder>
 void VoiceManager<Cfg, Responder, MonoResponder>::routeMIDIPitchBend(int16_t port, int16_t channel,
                                                                      int16_t pb14bit)
 {
-    if (dialect == MIDI1Dialect::MIDI1)
-    {
-        details.doMonoPitchBend(port, channel, pb14bit);
-    }
-    else if (dialect == MIDI1Dialect::MIDI1_MPE)
-    {
-        if (channel == mpeGlobalChannel)
-        {
-            details.doMonoPitchBend(port, -1, pb14bit);
-        }
-        else
-        {
-            details.doMPEPitchBend(port, channel, pb14bit);
-        }
-    }
-    else
-    {
-        // Code this dialect! What is it even?
-        assert(false);
-    }
+    using CK = typename Details::CoalescedController;
+    if ((coalesceControllers || details.dispatchingBlock) &&
+        details.coalesceController(CK::PITCH_BEND, port, channel, -1, pb14bit))
+        return;
+    details.deliverPitchBend(port, channel, pb14bit);
+}
+
+template <typename Cfg, typename Responder, typename MonoResponder>
+void VoiceManager<Cfg, Responder, MonoResponder>::flushCoalescedControllers(uint32_t sampleOffset)
+{
+    details.flushAllCoalescedControllers(sampleOffset);
 }
 
 template <typename Cfg, typename Responder, typename MonoResponder>
 size_t VoiceManager<Cfg, Responder, MonoResponder>::getVoiceCount() const
 {
     size_t res{0};
-    for (const auto &vi : details.voiceInfo)
+    for (auto *c : details.voiceInfo.hot.activeVoiceCookie)
     {
-        res += (vi.activeVoiceCookie != nullptr);
+        res += (c != nullptr);
     }
     return res;
 }
@@ -1401,9 +3031,10 @@ template <typename Cfg, typename Responder, typename MonoResponder>
 size_t VoiceManager<Cfg, Responder, MonoResponder>::getGatedVoiceCount() const
 {
     size_t res{0};
-    for (const auto &vi : details.voiceInfo)
+    const auto &hot = details.voiceInfo.hot;
+    for (size_t i = 0; i < hot.activeVoiceCookie.size(); ++i)
     {
-        res += (vi.activeVoiceCookie != nullptr && vi.gated) ? 1 : 0;
+        res += (hot.activeVoiceCookie[i] != nullptr && hot.gated[i]) ? 1 : 0;
     }
     return res;
 }
@@ -1414,12 +3045,14 @@ void VoiceManager<Cfg, Responder, MonoResponder>::routeNoteExpression(int16_t po
                                                                       int32_t expression,
                                                                       double value)
 {
-    for (auto &vi : details.voiceInfo)
+    auto hits = details.matchingVoiceSlots(port, channel, key, noteid);
+    for (auto idx : detail::SetBits{hits})
     {
-        if (vi.matches(port, channel, key,
-                       noteid)) // all keys and notes on a channel for midi PB
+        if (details.voiceMatches(idx, port, channel, key,
+                                 noteid)) // all keys and notes on a channel for midi PB
         {
-            responder.setNoteExpression(vi.activeVoiceCookie, expression, value);
+            responder.setNoteExpression(details.voiceInfo.hot.activeVoiceCookie[idx], expression,
+                                        value);
         }
     }
 }
@@ -1428,92 +3061,157 @@ template <typename Cfg, typename Responder, typename MonoResponder>
 void VoiceManager<Cfg, Responder, MonoResponder>::routePolyphonicParameterModulation(
     int16_t port, int16_t channel, int16_t key, int32_t voiceid, uint32_t parameter, double value)
 {
-    for (auto &vi : details.voiceInfo)
+    auto hits = details.matchingVoiceIdSlots(voiceid);
+    for (auto idx : detail::SetBits{hits})
     {
-        if (vi.matchesVoiceId(voiceid))
+        if (details.voiceMatchesVoiceId(idx, voiceid))
         {
-            responder.setVoicePolyphonicParameterModulation(vi.activeVoiceCookie, parameter, value);
+            responder.setVoicePolyphonicParameterModulation(
+                details.voiceInfo.hot.activeVoiceCookie[idx], parameter, value);
         }
     }
 }
 
 template <typename Cfg, typename Responder, typename MonoResponder>
-void VoiceManager<Cfg, Responder, MonoResponder>::routeMonophonicParameterModulation(
+void VoiceManager<Cfg, Responder, MonoResponder>::routeKeyedPolyphonicParameterModulation(
     int16_t port, int16_t channel, int16_t key, uint32_t parameter, double value)
 {
-    for (auto &vi : details.voiceInfo)
+    auto hits = details.matchingVoiceSlots(port, channel, key);
+    for (auto idx : detail::SetBits{hits})
     {
-        if (vi.activeVoiceCookie)
+        if (details.voiceMatches(idx, port, channel, key, -1))
         {
-            responder.setVoiceMonophonicParameterModulation(vi.activeVoiceCookie, parameter, value);
+            responder.setVoicePolyphonicParameterModulation(
+                details.voiceInfo.hot.activeVoiceCookie[idx], parameter, value);
         }
     }
 }
 
 template <typename Cfg, typename Responder, typename MonoResponder>
-void VoiceManager<Cfg, Responder, MonoResponder>::routePolyphonicAftertouch(int16_t port,
-                                                                            int16_t channel,
-                                                                            int16_t key, int8_t pat)
+void VoiceManager<Cfg, Responder, MonoResponder>::routeMonophonicParameterModulation(
+    int16_t port, int16_t channel, int16_t key, uint32_t parameter, double value)
 {
-    for (auto &vi : details.voiceInfo)
+    for (auto *cookie : details.voiceInfo.hot.activeVoiceCookie)
     {
-        if (vi.matches(port, channel, key, -1)) // all keys and notes on a channel for midi PB
+        if (cookie)
         {
-            responder.setPolyphonicAftertouch(vi.activeVoiceCookie, pat);
+            responder.setVoiceMonophonicParameterModulation(cookie, parameter, value);
         }
     }
 }
 
+template <typename Cfg, typename Responder, typename MonoResponder>
+void VoiceManager<Cfg, Responder, MonoResponder>::routePolyphonicAftertouch(int16_t port,
+                                                                            int16_t channel,
+                                                                            int16_t key, int8_t pat)
+{
+    using CK = typename Details::CoalescedController;
+    if ((coalesceControllers || details.dispatchingBlock) &&
+        details.coalesceController(CK::POLYPHONIC_AFTERTOUCH, port, channel, key, pat))
+        return;
+    details.deliverPolyphonicAftertouch(port, channel, key, pat);
+}
+
 template <typename Cfg, typename Responder, typename MonoResponder>
 void VoiceManager<Cfg, Responder, MonoResponder>::routeChannelPressure(int16_t port,
                                                                        int16_t channel, int8_t pat)
 {
-    if (dialect == MIDI1Dialect::MIDI1)
-    {
-        details.doMonoChannelPressure(port, channel, pat);
-    }
-    else if (dialect == MIDI1Dialect::MIDI1_MPE)
-    {
-        if (channel == mpeGlobalChannel)
-        {
-            details.doMonoChannelPressure(port, channel, pat);
-        }
-        else
-        {
-            details.doMPEChannelPressure(port, channel, pat);
-        }
-    }
+    using CK = typename Details::CoalescedController;
+    if ((coalesceControllers || details.dispatchingBlock) &&
+        details.coalesceController(CK::CHANNEL_PRESSURE, port, channel, -1, pat))
+        return;
+    details.deliverChannelPressure(port, channel, pat);
 }
 
 template <typename Cfg, typename Responder, typename MonoResponder>
 void VoiceManager<Cfg, Responder, MonoResponder>::routeMIDI1CC(int16_t port, int16_t channel,
                                                                int8_t cc, int8_t val)
 {
-    if (dialect == MIDI1Dialect::MIDI1_MPE && channel != mpeGlobalChannel && cc == mpeTimbreCC)
+    using CK = typename Details::CoalescedController;
+    if ((coalesceControllers || details.dispatchingBlock) &&
+        details.coalesceController(CK::MIDI1_CC, port, channel, cc, val))
+        return;
+    details.deliverMIDI1CC(port, channel, cc, val);
+}
+
+template <typename Cfg, typename Responder, typename MonoResponder>
+size_t
+VoiceManager<Cfg, Responder, MonoResponder>::processEvents(std::span<const VoiceEvent> events,
+                                                           uint32_t untilSample)
+{
+    using T = VoiceEvent::Type;
+    size_t done{0};
+    details.dispatchingBlock = true;
+    for (const auto &e : events)
     {
-        for (auto &vi : details.voiceInfo)
+        if (e.sampleOffset >= untilSample)
+            break;
+        // The previous offset is done with; what its controllers left held goes out once
+        if (done && e.sampleOffset != details.eventSampleOffset)
+            details.flushAllCoalescedControllers(details.eventSampleOffset);
+        details.eventSampleOffset = e.sampleOffset;
+        switch (e.type)
         {
-            if (vi.activeVoiceCookie && vi.port == port && vi.channel == channel && vi.gated)
-            {
-                responder.setVoiceMIDIMPETimbre(vi.activeVoiceCookie, val);
-            }
+        case T::NOTE_ON:
+            processNoteOnEvent(e.port, e.channel, e.key, e.noteId, static_cast<float>(e.value),
+                               e.retune);
+            break;
+        case T::NOTE_OFF:
+            processNoteOffEvent(e.port, e.channel, e.key, e.noteId, static_cast<float>(e.value));
+            break;
+        case T::SUSTAIN_PEDAL:
+            updateSustainPedal(e.port, e.channel, static_cast<int8_t>(e.data));
+            break;
+        case T::MIDI_PITCH_BEND:
+            routeMIDIPitchBend(e.port, e.channel, static_cast<int16_t>(e.data));
+            break;
+        case T::MIDI1_CC:
+            routeMIDI1CC(e.port, e.channel, static_cast<int8_t>(e.index),
+                         static_cast<int8_t>(e.data));
+            break;
+        case T::POLYPHONIC_AFTERTOUCH:
+            routePolyphonicAftertouch(e.port, e.channel, e.key, static_cast<int8_t>(e.data));
+            break;
+        case T::CHANNEL_PRESSURE:
+            routeChannelPressure(e.port, e.channel, static_cast<int8_t>(e.data));
+            break;
+        case T::NOTE_EXPRESSION:
+            routeNoteExpression(e.port, e.channel, e.key, e.noteId,
+                                static_cast<int32_t>(e.index), e.value);
+            break;
+        case T::POLYPHONIC_PARAMETER_MOD:
+            routePolyphonicParameterModulation(e.port, e.channel, e.key, e.noteId, e.index,
+                                               e.value);
+            break;
+        case T::KEYED_PARAMETER_MOD:
+            routeKeyedPolyphonicParameterModulation(e.port, e.channel, e.key, e.index, e.value);
+            break;
+        case T::MONOPHONIC_PARAMETER_MOD:
+            routeMonophonicParameterModulation(e.port, e.channel, e.key, e.index, e.value);
+            break;
         }
+        ++done;
     }
-    else
-    {
-        details.midiCCCache[channel][cc] = val;
-        monoResponder.setMIDI1CC(channel, cc, val);
-    }
+    if (done)
+        details.flushAllCoalescedControllers(details.eventSampleOffset);
+    details.eventSampleOffset = 0;
+    details.dispatchingBlock = false;
+    return done;
 }
 
+// These walk the active slots and read the cookie lane; a voice ended by an earlier
+// terminate in the same walk has a null cookie by its turn and is passed over.
 template <typename Cfg, typename Responder, typename MonoResponder>
 void VoiceManager<Cfg, Responder, MonoResponder>::allSoundsOff()
 {
-    for (const auto &v : details.voiceInfo)
+    details.flushAllCoalescedControllers(details.eventSampleOffset);
+    const auto &cookies = details.voiceInfo.hot.activeVoiceCookie;
+    auto active = details.activeVoiceSlots();
+    for (auto idx : detail::SetBits{active})
     {
-        if (v.activeVoiceCookie)
+        if (cookies[idx])
         {
-            responder.terminateVoice(v.activeVoiceCookie);
+            responder.terminateVoice(cookies[idx]);
         }
     }
 }
@@ -1522,11 +3220,14 @@ template <typename Cfg, typename Responder, typename MonoResponder>
 void VoiceManager<Cfg, Responder, MonoResponder>::allSoundsOffMatching(
     std::function<bool(typename Cfg::voice_t *)> pred)
 {
-    for (const auto &v : details.voiceInfo)
+    details.flushAllCoalescedControllers(details.eventSampleOffset);
+    const auto &cookies = details.voiceInfo.hot.activeVoiceCookie;
+    auto active = details.activeVoiceSlots();
+    for (auto idx : detail::SetBits{active})
     {
-        if (v.activeVoiceCookie && pred(v.activeVoiceCookie))
+        if (cookies[idx] && pred(cookies[idx]))
         {
-            responder.terminateVoice(v.activeVoiceCookie);
+            responder.terminateVoice(cookies[idx]);
         }
     }
 }
@@ -1534,13 +3235,17 @@ void VoiceManager<Cfg, Responder, MonoResponder>::allSoundsOffMatching(
 template <typename Cfg, typename Responder, typename MonoResponder>
 void VoiceManager<Cfg, Responder, MonoResponder>::allNotesOff()
 {
-    for (auto &v : details.voiceInfo)
+    details.flushAllCoalescedControllers(details.eventSampleOffset);
+    auto &hot = details.voiceInfo.hot;
+    auto active = details.activeVoiceSlots();
+    for (auto idx : detail::SetBits{active})
     {
-        if (v.activeVoiceCookie)
+        if (hot.activeVoiceCookie[idx])
         {
-            responder.releaseVoice(v.activeVoiceCookie, 0);
+            responder.releaseVoice(hot.activeVoiceCookie[idx], 0);
             VML("- Gated to False ***");
-            v.gated = false;
+            hot.gated[idx] = false;
+            details.syncStealCandidate(idx);
         }
     }
 }
@@ -1549,54 +3254,58 @@ template <typename Cfg, typename Responder, typename MonoResponder>
 void VoiceManager<Cfg, Responder, MonoResponder>::setPolyphonyGroupVoiceLimit(uint64_t groupId,
                                                                               int32_t limit)
 {
-    details.guaranteeGroup(groupId);
+    auto gi = details.guaranteeGroup(groupId);
+    if (gi == Details::noGroup)
+        return;
     // A limit below 1 or above the physical pool is meaningless; clamp rather than reject
     auto newLimit = std::clamp(limit, 1, static_cast<int32_t>(Cfg::maxVoiceCount));
-    details.group(groupId).polyLimit = newLimit;
+    details.updateGroupLimit(gi, newLimit);
 
     // Lowering the limit below the group's current active count steals the excess now
     // rather than waiting for the next note-on to enforce it.
-    auto excess = details.group(groupId).usedVoices - newLimit;
+    auto excess = details.groupAt(gi).usedVoices - newLimit;
     if (excess > 0)
-        details.stealVoicesFromGroup(groupId, excess);
+        details.stealVoicesFromGroup(gi, excess);
 }
 
 template <typename Cfg, typename Responder, typename MonoResponder>
 int32_t
 VoiceManager<Cfg, Responder, MonoResponder>::getPolyphonyGroupVoiceLimit(uint64_t groupId) const
 {
-    auto it = details.groups.find(groupId);
-    if (it == details.groups.end())
+    auto gi = details.findGroupIndex(groupId);
+    if (gi == Details::noGroup)
         return static_cast<int32_t>(Cfg::maxVoiceCount);
-    return it->second.polyLimit;
+    return details.groupAt(gi).polyLimit;
 }
 
 template <typename Cfg, typename Responder, typename MonoResponder>
 bool VoiceManager<Cfg, Responder, MonoResponder>::setPolyphonyGroupParent(uint64_t childGroup,
                                                                           uint64_t parentGroupId)
 {
-    details.guaranteeGroup(childGroup);
+    auto child = details.guaranteeGroup(childGroup);
+    if (child == Details::noGroup)
+        return false;
 
     if (parentGroupId == noPolyphonyGroupParent)
     {
-        details.group(childGroup).parentGroup = noPolyphonyGroupParent;
-        details.recomputeUsedVoices();
+        details.reparentGroup(child, Details::noGroup);
         return true;
     }
 
-    details.guaranteeGroup(parentGroupId);
+    auto parent = details.guaranteeGroup(parentGroupId);
+    if (parent == Details::noGroup)
+        return false;
 
     // Reject a cycle: parentGroupId may not already sit in childGroup's subtree
     // (childGroup == parentGroupId is the self-parent case and is caught here too).
-    if (details.isDescendantOrSelf(parentGroupId, childGroup))
+    if (details.isDescendantOrSelf(parent, child))
         return false;
 
     // Only leaf groups may be MONO; a parent must be POLY.
-    if (details.group(parentGroupId).playMode != PlayMode::POLY_VOICES)
+    if (details.groupAt(parent).playMode != PlayMode::POLY_VOICES)
         return false;
 
-    details.group(childGroup).parentGroup = parentGroupId;
-    details.recomputeUsedVoices();
+    details.reparentGroup(child, parent);
     return true;
 }
 
@@ -1604,38 +3313,35 @@ template <typename Cfg, typename Responder, typename MonoResponder>
 bool VoiceManager<Cfg, Responder, MonoResponder>::setPlaymode(uint64_t groupId, PlayMode pm,
                                                               uint64_t features)
 {
-    details.guaranteeGroup(groupId);
+    auto gi = details.guaranteeGroup(groupId);
+    if (gi == Details::noGroup)
+        return false;
 
     // Only leaf groups may be MONO; a group with children must stay POLY so the mono
     // machinery (which keys on a voice's exact leaf group) never silently no-ops.
-    if (pm != PlayMode::POLY_VOICES && details.hasChildren(groupId))
+    if (pm != PlayMode::POLY_VOICES && details.hasChildren(gi))
         return false;
 
     // Changing the play mode or features of a group while voices are sounding leaves
     // those voices in a mode they were not started under. Rather than try to reconcile,
     // hard-terminate every voice in the group (an allSoundsOff scoped to the group) and
     // clear its held-key state so a later note-off cannot resurrect a voice from it.
-    bool modeChanged = details.group(groupId).playMode != pm ||
-                       details.group(groupId).playModeFeatures != features;
+    bool modeChanged = details.groupAt(gi).playMode != pm ||
+                       details.groupAt(gi).playModeFeatures != features;
     if (modeChanged)
     {
-        for (const auto &vi : details.voiceInfo)
-        {
-            if (vi.activeVoiceCookie && vi.polyGroup == groupId)
+        details.forEachVoiceInGroupBySlot(
+            gi,
+            [&](auto vidx)
             {
+                const auto vi = details.voiceInfo[vidx];
                 responder.terminateVoice(vi.activeVoiceCookie);
-            }
-        }
-        for (auto &[p, ks] : details.keyStateByPort)
-        {
-            for (auto &chState : ks)
-                for (auto &keyState : chState)
-                    keyState.erase(groupId);
-        }
+            });
+        details.clearGroupKeyState(groupId);
     }
 
-    details.group(groupId).playMode = pm;
-    details.group(groupId).playModeFeatures = features;
+    details.groupAt(gi).playMode = pm;
+    details.groupAt(gi).playModeFeatures = features;
     return true;
 }
 
@@ -1643,26 +3349,28 @@ template <typename Cfg, typename Responder, typename MonoResponder>
 typename VoiceManager<Cfg, Responder, MonoResponder>::PlayMode
 VoiceManager<Cfg, Responder, MonoResponder>::getPlaymode(uint64_t groupId) const
 {
-    auto it = details.groups.find(groupId);
-    if (it == details.groups.end())
+    auto gi = details.findGroupIndex(groupId);
+    if (gi == Details::noGroup)
         return PlayMode::POLY_VOICES;
-    return it->second.playMode;
+    return details.groupAt(gi).playMode;
 }
 
 template <typename Cfg, typename Responder, typename MonoResponder>
 void VoiceManager<Cfg, Responder, MonoResponder>::setStealingPriorityMode(uint64_t groupId,
                                                                           StealingPriorityMode pm)
 {
-    details.guaranteeGroup(groupId);
-    details.group(groupId).stealingPriorityMode = pm;
+    auto gi = details.guaranteeGroup(groupId);
+    if (gi != Details::noGroup)
+        details.groupAt(gi).stealingPriorityMode = pm;
 }
 
 template <typename Cfg, typename Responder, typename MonoResponder>
 void VoiceManager<Cfg, Responder, MonoResponder>::setMonoPriorityMode(uint64_t groupId,
                                                                       MonoPriorityMode pm)
 {
-    details.guaranteeGroup(groupId);
-    details.group(groupId).monoPriorityMode = pm;
+    auto gi = details.guaranteeGroup(groupId);
+    if (gi != Details::noGroup)
+        details.groupAt(gi).monoPriorityMode = pm;
 }
 
 template <typename Cfg, typename Responder, typename MonoResponder>
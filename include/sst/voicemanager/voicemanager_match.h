@@ -0,0 +1,202 @@
+/*
+ * sst-voicemanager - a header only library providing synth
+ * voice management in response to midi and clap event streams
+ * with support for a variety of play, trigger, and midi nodes
+ *
+ * Copyright 2023-2024, various authors, as described in the GitHub
+ * transaction log.
+ *
+ * sst-voicemanager is released under the MIT license, available
+ * as LICENSE.md in the root of this repository.
+ *
+ * All source in sst-voicemanager available at
+ * https://github.com/surge-synthesizer/sst-voicemanager
+ */
+
+#ifndef INCLUDE_SST_VOICEMANAGER_VOICEMANAGER_MATCH_H
+#define INCLUDE_SST_VOICEMANAGER_VOICEMANAGER_MATCH_H
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * Define SST_VOICEMANAGER_SCALAR_MATCH to force the portable matcher on any platform.
+ */
+#if !defined(SST_VOICEMANAGER_SCALAR_MATCH)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SST_VOICEMANAGER_MATCH_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SST_VOICEMANAGER_MATCH_NEON 1
+#include <arm_neon.h>
+#endif
+#endif
+
+/*
+ * Matching a (port, channel, key) query against every voice slot. The voice manager keeps
+ * those as parallel int16_t lanes, so we can compare eight slots at a time and hand back a
+ * bitmask of the slots which match, and the router only visits the set bits.
+ */
+namespace sst::voicemanager::detail
+{
+template <size_t N> using SlotMask = std::array<uint64_t, (N + 63) / 64>;
+
+template <size_t W> inline void setSlotBit(std::array<uint64_t, W> &m, int32_t i)
+{
+    m[i >> 6] |= 1ULL << (i & 63);
+}
+template <size_t W> inline void clearSlotBit(std::array<uint64_t, W> &m, int32_t i)
+{
+    m[i >> 6] &= ~(1ULL << (i & 63));
+}
+template <size_t W> inline bool testSlotBit(const std::array<uint64_t, W> &m, int32_t i)
+{
+    return m[i >> 6] & (1ULL << (i & 63));
+}
+template <size_t W> inline bool anySlotBit(const std::array<uint64_t, W> &m)
+{
+    for (auto w : m)
+        if (w)
+            return true;
+    return false;
+}
+
+/**
+ * A field matches if either the query or the voice holds the -1 wildcard, or they are equal.
+ */
+inline bool laneMatches(int16_t voice, int16_t query)
+{
+    return query == -1 || voice == -1 || voice == query;
+}
+
+inline uint32_t matchEightScalar(const int16_t *port, const int16_t *channel, const int16_t *key,
+                                 int16_t pt, int16_t ch, int16_t k, size_t count = 8)
+{
+    uint32_t res{0};
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto m = laneMatches(port[i], pt) && laneMatches(channel[i], ch) && laneMatches(key[i], k);
+        res |= static_cast<uint32_t>(m) << i;
+    }
+    return res;
+}
+
+#if defined(SST_VOICEMANAGER_MATCH_SSE2)
+inline __m128i matchLaneSSE2(const int16_t *lane, int16_t q)
+{
+    auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(lane));
+    return _mm_or_si128(_mm_cmpeq_epi16(v, _mm_set1_epi16(q)),
+                        _mm_cmpeq_epi16(v, _mm_set1_epi16(-1)));
+}
+
+inline uint32_t matchEight(const int16_t *port, const int16_t *channel, const int16_t *key,
+                           int16_t pt, int16_t ch, int16_t k)
+{
+    auto m = _mm_set1_epi16(-1);
+    if (pt != -1)
+        m = _mm_and_si128(m, matchLaneSSE2(port, pt));
+    if (ch != -1)
+        m = _mm_and_si128(m, matchLaneSSE2(channel, ch));
+    if (k != -1)
+        m = _mm_and_si128(m, matchLaneSSE2(key, k));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_packs_epi16(m, _mm_setzero_si128()))) &
+           0xFF;
+}
+#elif defined(SST_VOICEMANAGER_MATCH_NEON)
+inline uint16x8_t matchLaneNEON(const int16_t *lane, int16_t q)
+{
+    auto v = vld1q_s16(lane);
+    return vorrq_u16(vceqq_s16(v, vdupq_n_s16(q)), vceqq_s16(v, vdupq_n_s16(-1)));
+}
+
+inline uint32_t matchEight(const int16_t *port, const int16_t *channel, const int16_t *key,
+                           int16_t pt, int16_t ch, int16_t k)
+{
+    static constexpr uint16_t laneBits[8] = {1, 2, 4, 8, 16, 32, 64, 128};
+    auto m = vdupq_n_u16(0xFFFF);
+    if (pt != -1)
+        m = vandq_u16(m, matchLaneNEON(port, pt));
+    if (ch != -1)
+        m = vandq_u16(m, matchLaneNEON(channel, ch));
+    if (k != -1)
+        m = vandq_u16(m, matchLaneNEON(key, k));
+    return vaddvq_u16(vandq_u16(m, vld1q_u16(laneBits)));
+}
+#else
+inline uint32_t matchEight(const int16_t *port, const int16_t *channel, const int16_t *key,
+                           int16_t pt, int16_t ch, int16_t k)
+{
+    return matchEightScalar(port, channel, key, pt, ch, k);
+}
+#endif
+
+/**
+ * Set bit i of the result for each slot i whose port, channel and key lanes match the query
+ * under laneMatches. This looks only at the lanes; the caller masks off inactive slots.
+ */
+template <size_t N>
+inline SlotMask<N> matchVoiceLanes(const std::array<int16_t, N> &port,
+                                   const std::array<int16_t, N> &channel,
+                                   const std::array<int16_t, N> &key, int16_t pt, int16_t ch,
+                                   int16_t k)
+{
+    SlotMask<N> res{};
+    size_t i{0};
+    for (; i + 8 <= N; i += 8)
+    {
+        auto bits = matchEight(port.data() + i, channel.data() + i, key.data() + i, pt, ch, k);
+        res[i >> 6] |= static_cast<uint64_t>(bits) << (i & 63);
+    }
+    if (i < N)
+    {
+        auto bits = matchEightScalar(port.data() + i, channel.data() + i, key.data() + i, pt,
+                                     ch, k, N - i);
+        res[i >> 6] |= static_cast<uint64_t>(bits) << (i & 63);
+    }
+    return res;
+}
+
+/**
+ * Iterate the set bits of a SlotMask, lowest first, as slot indices.
+ */
+template <size_t W> struct SetBits
+{
+    const std::array<uint64_t, W> &words;
+
+    struct iterator
+    {
+        const std::array<uint64_t, W> *words;
+        size_t word;
+        uint64_t bits;
+
+        void skipEmpty()
+        {
+            while (bits == 0 && ++word < W)
+                bits = (*words)[word];
+        }
+        int32_t operator*() const
+        {
+            return static_cast<int32_t>((word << 6) + std::countr_zero(bits));
+        }
+        iterator &operator++()
+        {
+            bits &= bits - 1;
+            skipEmpty();
+            return *this;
+        }
+        bool operator!=(const iterator &o) const { return word != o.word || bits != o.bits; }
+    };
+
+    iterator begin() const
+    {
+        auto it = iterator{&words, 0, words[0]};
+        it.skipEmpty();
+        return it;
+    }
+    iterator end() const { return iterator{&words, W, 0}; }
+};
+} // namespace sst::voicemanager::detail
+
+#endif // INCLUDE_SST_VOICEMANAGER_VOICEMANAGER_MATCH_H
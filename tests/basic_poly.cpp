@@ -616,6 +616,47 @@ TEST_CASE("VM Voice Count drops post release")
     REQUIRE(vm.getVoiceCount() == 0);
 }
 
+TEST_CASE("VM Voice Count follows voices ending out of order")
+{
+    TestPlayer<8> tp;
+    auto &vm = tp.voiceManager;
+
+    for (int k = 50; k < 58; ++k)
+        vm.processNoteOnEvent(0, 0, k, -1, 0.8, 0.0);
+    REQUIRE_VOICE_COUNTS(8, 8);
+
+    // The synth ends voices on its own, in no particular order, through the end callback
+    for (auto i : {5, 0, 7, 2})
+    {
+        auto &v = tp.voiceStorage[i];
+        REQUIRE(v.key() == 50 + i);
+        tp.voiceEndCallback(&v);
+        v = TestPlayer<8>::Voice();
+    }
+    REQUIRE_VOICE_COUNTS(4, 4);
+
+    // Ending a voice which has already gone is ignored
+    tp.voiceEndCallback(&tp.voiceStorage[0]);
+    REQUIRE_VOICE_COUNTS(4, 4);
+
+    // The freed slots take new notes without stealing the survivors
+    for (int k = 60; k < 64; ++k)
+        vm.processNoteOnEvent(0, 0, k, -1, 0.8, 0.0);
+    REQUIRE_VOICE_COUNTS(8, 8);
+    for (auto k : {51, 53, 54, 56, 60, 61, 62, 63})
+        REQUIRE(tp.activeVoicesMatching([k](auto &v) { return v.key() == k; }) == 1);
+
+    // and once they are all taken a new note steals just one
+    vm.processNoteOnEvent(0, 0, 70, -1, 0.8, 0.0);
+    REQUIRE_VOICE_COUNTS(8, 8);
+    REQUIRE_KEY_COUNT(1, 70);
+
+    for (int k = 50; k < 71; ++k)
+        vm.processNoteOffEvent(0, 0, k, -1, 0.4);
+    tp.processFor(10);
+    REQUIRE_NO_VOICES;
+}
+
 TEST_CASE("HeldMIDIKeyByChannel Basic State")
 {
     TestPlayer<32> tp;
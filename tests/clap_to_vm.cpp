@@ -0,0 +1,225 @@
+/*
+ * sst-voicemanager - a header only library providing synth
+ * voice management in response to midi and clap event streams
+ * with support for a variety of play, trigger, and midi nodes
+ *
+ * Copyright 2023-2024, various authors, as described in the GitHub
+ * transaction log.
+ *
+ * sst-voicemanager is released under the MIT license, available
+ * as LICENSE.md in the root of this repository.
+ *
+ * All source in sst-voicemanager available at
+ * https://github.com/surge-synthesizer/sst-voicemanager
+ */
+
+#include "catch2.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/*
+ * A stand-in for the parts of <clap/events.h> the adapter reads, with the same names and
+ * layout, so the test doesn't need the CLAP headers.
+ */
+typedef struct clap_event_header
+{
+    uint32_t size;
+    uint32_t time;
+    uint16_t space_id;
+    uint16_t type;
+    uint32_t flags;
+} clap_event_header_t;
+
+static constexpr uint16_t CLAP_CORE_EVENT_SPACE_ID = 0;
+enum
+{
+    CLAP_EVENT_NOTE_ON = 0,
+    CLAP_EVENT_NOTE_OFF = 1,
+    CLAP_EVENT_NOTE_CHOKE = 2,
+    CLAP_EVENT_NOTE_END = 3,
+    CLAP_EVENT_NOTE_EXPRESSION = 4,
+    CLAP_EVENT_PARAM_VALUE = 5,
+    CLAP_EVENT_PARAM_MOD = 6,
+    CLAP_EVENT_MIDI = 10,
+};
+
+typedef struct clap_event_note
+{
+    clap_event_header_t header;
+    int32_t note_id;
+    int16_t port_index;
+    int16_t channel;
+    int16_t key;
+    double velocity;
+} clap_event_note_t;
+
+typedef struct clap_event_note_expression
+{
+    clap_event_header_t header;
+    int32_t expression_id;
+    int32_t note_id;
+    int16_t port_index;
+    int16_t channel;
+    int16_t key;
+    double value;
+} clap_event_note_expression_t;
+
+typedef struct clap_event_param_mod
+{
+    clap_event_header_t header;
+    uint32_t param_id;
+    void *cookie;
+    int32_t note_id;
+    int16_t port_index;
+    int16_t channel;
+    int16_t key;
+    double amount;
+} clap_event_param_mod_t;
+
+typedef struct clap_event_midi
+{
+    clap_event_header_t header;
+    uint16_t port_index;
+    uint8_t data[3];
+} clap_event_midi_t;
+
+typedef struct clap_input_events
+{
+    void *ctx;
+    uint32_t (*size)(const struct clap_input_events *list);
+    const clap_event_header_t *(*get)(const struct clap_input_events *list, uint32_t index);
+} clap_input_events_t;
+
+#include "sst/voicemanager/voicemanager.h"
+#include "sst/voicemanager/clap_to_voicemanager.h"
+#include "test_player.h"
+
+namespace
+{
+template <typename T> clap_event_header_t header(uint16_t type, uint32_t time = 0)
+{
+    return {sizeof(T), time, CLAP_CORE_EVENT_SPACE_ID, type, 0};
+}
+
+clap_event_note_t note(uint16_t type, int16_t key, int32_t nid, double vel = 0.8)
+{
+    return {header<clap_event_note_t>(type), nid, 0, 0, key, vel};
+}
+
+// An input event list over pointers into caller-owned events, as a host would hand over
+struct EventList
+{
+    std::vector<const clap_event_header_t *> events;
+    clap_input_events_t list{this, &EventList::size, &EventList::get};
+
+    template <typename T> void add(const T &e)
+    {
+        events.push_back(reinterpret_cast<const clap_event_header_t *>(&e));
+    }
+    static uint32_t size(const clap_input_events_t *l)
+    {
+        return static_cast<uint32_t>(static_cast<EventList *>(l->ctx)->events.size());
+    }
+    static const clap_event_header_t *get(const clap_input_events_t *l, uint32_t i)
+    {
+        return static_cast<EventList *>(l->ctx)->events[i];
+    }
+};
+} // namespace
+
+TEST_CASE("CLAP Notes And Note Expressions")
+{
+    auto tp = TestPlayer<32>();
+    auto &vm = tp.voiceManager;
+
+    auto on60 = note(CLAP_EVENT_NOTE_ON, 60, 1060);
+    auto on62 = note(CLAP_EVENT_NOTE_ON, 62, 1062, 1.0);
+    clap_event_note_expression_t expr{
+        header<clap_event_note_expression_t>(CLAP_EVENT_NOTE_EXPRESSION), 2, 1062, 0, 0, 62,
+        0.37};
+    auto off60 = note(CLAP_EVENT_NOTE_OFF, 60, 1060, 0.5);
+
+    EventList el;
+    el.add(on60);
+    el.add(on62);
+    el.add(expr);
+    el.add(off60);
+    sst::voicemanager::applyClapInputEvents(vm, &el.list);
+
+    REQUIRE_VOICE_COUNTS(2, 1);
+    REQUIRE(tp.activeVoicesMatching([](auto &v)
+                                    { return v.key() == 62 && v.noteid() == 1062 && v.isGated; }) ==
+            1);
+    REQUIRE(tp.activeVoicesMatching(
+                [](auto &v)
+                {
+                    auto it = v.noteExpressionCache.find(2);
+                    return it != v.noteExpressionCache.end() && it->second == 0.37;
+                }) == 1);
+    REQUIRE(tp.activeVoicesMatching([](auto &v) { return v.key() == 60 && !v.isGated; }) == 1);
+}
+
+TEST_CASE("CLAP Parameter Modulation")
+{
+    auto tp = TestPlayer<32>();
+    auto &vm = tp.voiceManager;
+
+    auto on60 = note(CLAP_EVENT_NOTE_ON, 60, 1060);
+    auto on64 = note(CLAP_EVENT_NOTE_ON, 64, 1064);
+    clap_event_param_mod_t poly{
+        header<clap_event_param_mod_t>(CLAP_EVENT_PARAM_MOD), 77, nullptr, 1064, -1, -1, -1,
+        0.5};
+    clap_event_param_mod_t mono{
+        header<clap_event_param_mod_t>(CLAP_EVENT_PARAM_MOD), 78, nullptr, -1, -1, -1, -1, 0.25};
+    // No note id, but a key: polyphonic on the voices of that key only
+    clap_event_param_mod_t byKey{
+        header<clap_event_param_mod_t>(CLAP_EVENT_PARAM_MOD), 79, nullptr, -1, -1, -1, 60, 0.75};
+
+    EventList el;
+    el.add(on60);
+    el.add(on64);
+    el.add(poly);
+    el.add(mono);
+    el.add(byKey);
+    sst::voicemanager::applyClapInputEvents(vm, &el.list);
+
+    REQUIRE_VOICE_COUNTS(2, 2);
+    REQUIRE(tp.activeVoicesMatching([](auto &v)
+                                    { return v.paramModulationCache.count(77) == 1; }) == 1);
+    REQUIRE(tp.activeVoicesMatching(
+                [](auto &v)
+                { return v.key() == 64 && v.paramModulationCache.at(77) == 0.5; }) == 1);
+    REQUIRE(tp.activeVoicesMatching(
+                [](auto &v) { return v.monoParamModulationCache.count(78) == 1; }) == 2);
+    REQUIRE(tp.activeVoicesMatching([](auto &v)
+                                    { return v.paramModulationCache.count(79) == 1; }) == 1);
+    REQUIRE(tp.activeVoicesMatching(
+                [](auto &v) { return v.key() == 60 && v.paramModulationCache.at(79) == 0.75; }) ==
+            1);
+    REQUIRE(tp.activeVoicesMatching(
+                [](auto &v) { return v.monoParamModulationCache.count(79) == 1; }) == 0);
+}
+
+TEST_CASE("CLAP MIDI And Ignored Events")
+{
+    auto tp = TestPlayer<32>();
+    auto &vm = tp.voiceManager;
+
+    clap_event_midi_t noteOn{header<clap_event_midi_t>(CLAP_EVENT_MIDI), 0, {0x90, 60, 127}};
+    clap_event_midi_t cc{header<clap_event_midi_t>(CLAP_EVENT_MIDI), 0, {0xB3, 7, 99}};
+    auto choke = note(CLAP_EVENT_NOTE_CHOKE, 60, -1);
+    auto foreign = note(CLAP_EVENT_NOTE_ON, 62, -1);
+    foreign.header.space_id = 0x4242;
+
+    EventList el;
+    el.add(noteOn);
+    el.add(cc);
+    el.add(choke);
+    el.add(foreign);
+    sst::voicemanager::applyClapInputEvents(vm, &el.list);
+
+    REQUIRE_VOICE_COUNTS(1, 1);
+    REQUIRE(tp.activeVoicesMatching([](auto &v) { return v.key() == 60; }) == 1);
+    REQUIRE(tp.midi1CC[3][7] == 99);
+}
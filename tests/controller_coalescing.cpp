@@ -0,0 +1,202 @@
+/*
+ * sst-voicemanager - a header only library providing synth
+ * voice management in response to midi and clap event streams
+ * with support for a variety of play, trigger, and midi nodes
+ *
+ * Copyright 2023-2024, various authors, as described in the GitHub
+ * transaction log.
+ *
+ * sst-voicemanager is released under the MIT license, available
+ * as LICENSE.md in the root of this repository.
+ *
+ * All source in sst-voicemanager available at
+ * https://github.com/surge-synthesizer/sst-voicemanager
+ */
+
+#include "catch2.hpp"
+
+#include "sst/voicemanager/voicemanager.h"
+#include "sst/voicemanager/midi1_to_voicemanager.h"
+#include "test_player.h"
+
+TEST_CASE("Coalesced MPE Controllers Deliver The Latest Value On Flush")
+{
+    auto tp = TestPlayer<32>();
+    auto &vm = tp.voiceManager;
+    vm.dialect = TestPlayer<32>::voiceManager_t::MIDI1Dialect::MIDI1_MPE;
+    vm.coalesceControllers = true;
+
+    vm.processNoteOnEvent(0, 1, 60, -1, 0.8, 0.0);
+    vm.processNoteOnEvent(0, 2, 62, -1, 0.8, 0.0);
+    REQUIRE_VOICE_COUNTS(2, 2);
+
+    for (int i = 0; i < 64; ++i)
+    {
+        vm.routeMIDIPitchBend(0, 1, 8192 + i * 10);
+        vm.routeChannelPressure(0, 2, i);
+        vm.routeMIDI1CC(0, 1, 74, i);
+        vm.routePolyphonicAftertouch(0, 2, 62, 127 - i);
+    }
+    // Nothing has gone out yet
+    REQUIRE(tp.activeVoicesMatching(
+                [](auto &v)
+                { return v.mpeBend == 0 && v.mpePressure == 0 && v.mpeTimbre == 0; }) == 2);
+
+    vm.flushCoalescedControllers();
+    REQUIRE(tp.activeVoicesMatching(
+                [](auto &v)
+                { return v.key() == 60 && v.mpeBend == 8192 + 630 && v.mpeTimbre == 63; }) == 1);
+    REQUIRE(tp.activeVoicesMatching(
+                [](auto &v)
+                { return v.key() == 62 && v.mpePressure == 63 && v.polyATValue == 64; }) == 1);
+
+    // A second flush has nothing left to send
+    vm.routeMIDIPitchBend(0, 1, 100);
+    vm.flushCoalescedControllers();
+    vm.flushCoalescedControllers();
+    REQUIRE(tp.activeVoicesMatching([](auto &v) { return v.mpeBend == 100; }) == 1);
+}
+
+TEST_CASE("Coalesced Controllers Keep Note Semantics")
+{
+    SECTION("A Note Off Sees Its Channel's Held Bend")
+    {
+        auto tp = TestPlayer<32>();
+        auto &vm = tp.voiceManager;
+        vm.dialect = TestPlayer<32>::voiceManager_t::MIDI1Dialect::MIDI1_MPE;
+        vm.coalesceControllers = true;
+
+        vm.processNoteOnEvent(0, 1, 60, -1, 0.8, 0.0);
+        vm.processNoteOnEvent(0, 2, 62, -1, 0.8, 0.0);
+        vm.routeMIDIPitchBend(0, 1, 9000);
+        vm.routeMIDIPitchBend(0, 2, 7000);
+
+        // Bend only reaches gated MPE voices, so channel 1's must land before its release,
+        // while channel 2's stays held
+        vm.processNoteOffEvent(0, 1, 60, -1, 0.5);
+        REQUIRE(tp.activeVoicesMatching([](auto &v)
+                                        { return v.key() == 60 && v.mpeBend == 9000; }) == 1);
+        REQUIRE(tp.activeVoicesMatching([](auto &v)
+                                        { return v.key() == 62 && v.mpeBend == 0; }) == 1);
+
+        vm.flushCoalescedControllers();
+        REQUIRE(tp.activeVoicesMatching([](auto &v)
+                                        { return v.key() == 62 && v.mpeBend == 7000; }) == 1);
+    }
+
+    SECTION("A Note On Sees Its Channel's Held CC And Bend")
+    {
+        auto tp = TestPlayer<32>();
+        auto &vm = tp.voiceManager;
+        vm.coalesceControllers = true;
+
+        vm.routeMIDI1CC(0, 0, 1, 40);
+        vm.routeMIDI1CC(0, 0, 1, 90);
+        vm.routeMIDIPitchBend(0, 0, 10000);
+        vm.routeMIDI1CC(0, 3, 1, 20);
+        REQUIRE(tp.midi1CC[0][1] == 0);
+        REQUIRE(tp.pitchBend[0] == 0);
+
+        vm.processNoteOnEvent(0, 0, 60, -1, 0.8, 0.0);
+        REQUIRE(tp.midi1CC[0][1] == 90);
+        REQUIRE(tp.pitchBend[0] == 10000);
+        REQUIRE(tp.midi1CC[3][1] == 0);
+
+        vm.flushCoalescedControllers();
+        REQUIRE(tp.midi1CC[3][1] == 20);
+    }
+    SECTION("An MPE Note On Sees The Global Channel's Held CC And Bend")
+    {
+        auto tp = TestPlayer<32>();
+        auto &vm = tp.voiceManager;
+        vm.dialect = TestPlayer<32>::voiceManager_t::MIDI1Dialect::MIDI1_MPE;
+        vm.coalesceControllers = true;
+
+        vm.processNoteOnEvent(0, 3, 62, -1, 0.8, 0.0);
+        vm.routeMIDI1CC(0, 0, 1, 90);
+        vm.routeMIDIPitchBend(0, 0, 10000);
+        vm.routeMIDIPitchBend(0, 3, 7000);
+        REQUIRE(tp.midi1CC[0][1] == 0);
+        REQUIRE(tp.pitchBend[0] == 0);
+
+        // A member channel note takes the global values, but not another member's
+        vm.processNoteOnEvent(0, 1, 60, -1, 0.8, 0.0);
+        REQUIRE(tp.midi1CC[0][1] == 90);
+        REQUIRE(tp.pitchBend[0] == 10000);
+        REQUIRE(tp.activeVoicesMatching([](auto &v)
+                                        { return v.key() == 62 && v.mpeBend == 0; }) == 1);
+        vm.flushCoalescedControllers();
+        REQUIRE(tp.activeVoicesMatching([](auto &v)
+                                        { return v.key() == 62 && v.mpeBend == 7000; }) == 1);
+    }
+}
+
+TEST_CASE("Coalesced Controllers Carry The Flush Offset")
+{
+    auto tp = TestPlayer<32>();
+    auto &vm = tp.voiceManager;
+    vm.coalesceControllers = true;
+
+    vm.processNoteOnEvent(0, 1, 60, -1, 0.8, 0.0);
+    vm.routeMIDIPitchBend(0, 1, 9000);
+    vm.routePolyphonicAftertouch(0, 1, 60, 90);
+    vm.flushCoalescedControllers(128);
+    REQUIRE(tp.pitchBend[1] == 9000);
+    REQUIRE(tp.monoCoalescedOffset == 128);
+    REQUIRE(tp.coalescedOffset == 128);
+
+    // Flushed ahead of a note called directly, a value carries offset 0
+    vm.routeMIDIPitchBend(0, 1, 7000);
+    vm.processNoteOnEvent(0, 1, 62, -1, 0.8, 0.0);
+    REQUIRE(tp.pitchBend[1] == 7000);
+    REQUIRE(tp.monoCoalescedOffset == 0);
+    REQUIRE(tp.coalescedOffset == 0);
+
+    // Through processEvents it carries the offset of the note it went out ahead of
+    using ev_t = sst::voicemanager::VoiceEvent;
+    vm.routeMIDIPitchBend(0, 1, 6000);
+    auto ev = ev_t::noteOff(37, 0, 1, 62, -1, 0.5f);
+    REQUIRE(vm.processEvents({&ev, 1}) == 1);
+    REQUIRE(tp.pitchBend[1] == 6000);
+    REQUIRE(tp.monoCoalescedOffset == 37);
+    REQUIRE(tp.coalescedOffset == 37);
+}
+
+TEST_CASE("All Notes And Sounds Off Flush Held Controllers First")
+{
+    SECTION("All Notes Off Through CC 123")
+    {
+        auto tp = TestPlayer<32>();
+        auto &vm = tp.voiceManager;
+        vm.dialect = TestPlayer<32>::voiceManager_t::MIDI1Dialect::MIDI1_MPE;
+        vm.coalesceControllers = true;
+
+        // Bend reaches only gated MPE voices, so it must land before the release
+        vm.processNoteOnEvent(0, 1, 60, -1, 0.8, 0.0);
+        vm.routeMIDIPitchBend(0, 1, 9000);
+        vm.routeMIDI1CC(0, 4, 1, 90);
+        uint8_t msg[3]{0xB1, 123, 0};
+        sst::voicemanager::applyMidi1Message(vm, 0, msg);
+        REQUIRE(tp.activeVoicesMatching([](auto &v)
+                                        { return v.key() == 60 && v.mpeBend == 9000; }) == 1);
+        REQUIRE(tp.midi1CC[4][1] == 90);
+        REQUIRE_VOICE_COUNTS(1, 0);
+    }
+    SECTION("All Sounds Off Through CC 120")
+    {
+        auto tp = TestPlayer<32>();
+        auto &vm = tp.voiceManager;
+        vm.coalesceControllers = true;
+
+        vm.processNoteOnEvent(0, 2, 60, -1, 0.8, 0.0);
+        vm.routeMIDIPitchBend(0, 2, 7000);
+        vm.routeChannelPressure(0, 5, 33);
+        REQUIRE(tp.pitchBend[2] == 0);
+
+        uint8_t msg[3]{0xB2, 120, 0};
+        sst::voicemanager::applyMidi1Message(vm, 0, msg);
+        REQUIRE(tp.pitchBend[2] == 7000);
+        REQUIRE(tp.channelPressure[5] == 33);
+        REQUIRE_VOICE_COUNTS(0, 0);
+    }
+}
@@ -334,3 +334,161 @@ TEST_CASE("Hierarchy - detaching restores root behavior")
         vm.processNoteOnEvent(0, 0, 10 + i, -1, 0.8, 0.0);
     REQUIRE_VOICE_COUNTS(6, 6);
 }
+
+TEST_CASE("Hierarchy - moving a subtree moves its steal scope")
+{
+    // G1 (leaf) -> G2 starts as its own tree; R=4 holds leaf S. Moving G2 under R brings
+    // G1's voices into R's subtree, so R's budget now steals them.
+    constexpr uint64_t G1{11}, G2{12}, R{13}, S{14};
+    TestPlayer<64> tp;
+    auto &vm = tp.voiceManager;
+    vm.setPolyphonyGroupVoiceLimit(G1, 8);
+    vm.setPolyphonyGroupVoiceLimit(G2, 8);
+    vm.setPolyphonyGroupVoiceLimit(R, 4);
+    vm.setPolyphonyGroupVoiceLimit(S, 8);
+    REQUIRE(vm.setPolyphonyGroupParent(G1, G2));
+    REQUIRE(vm.setPolyphonyGroupParent(S, R));
+    tp.polyGroupForKey = [](int16_t k) -> uint64_t { return k < 20 ? G1 : S; };
+
+    vm.processNoteOnEvent(0, 0, 10, -1, 0.8, 0.0);
+    vm.processNoteOnEvent(0, 0, 11, -1, 0.8, 0.0);
+    REQUIRE_VOICE_COUNTS(2, 2);
+
+    REQUIRE(vm.setPolyphonyGroupParent(G2, R));
+    // R is now an ancestor of G1, so hanging R below G1 would close a cycle
+    REQUIRE_FALSE(vm.setPolyphonyGroupParent(R, G1));
+
+    for (int i = 0; i < 3; ++i)
+        vm.processNoteOnEvent(0, 0, 20 + i, -1, 0.8, 0.0);
+    // The third S note overfills R and takes the oldest voice in R's subtree
+    REQUIRE_VOICE_COUNTS(4, 4);
+    REQUIRE(tp.activeVoicesMatching([](auto &v) { return v.key() == 10; }) == 0);
+    REQUIRE(tp.activeVoicesMatching([](auto &v) { return v.key() == 11; }) == 1);
+    REQUIRE(tp.activeVoicesMatching([](auto &v) { return v.key() >= 20; }) == 3);
+}
+
+TEST_CASE("Hierarchy - reparenting with held voices moves budget and steal scope at once")
+{
+    // P1 -> M -> L and P2 -> X. M's subtree (holding L's voices) is moved between P1, P2
+    // and the roots, both forwards and backwards in the group order, with notes held.
+    constexpr uint64_t P1{41}, P2{42}, L{43}, M{44}, X{45};
+    TestPlayer<64> tp;
+    auto &vm = tp.voiceManager;
+    using vm_t = TestPlayer<64>::voiceManager_t;
+    vm.setPolyphonyGroupVoiceLimit(P1, 4);
+    vm.setPolyphonyGroupVoiceLimit(P2, 3);
+    vm.setPolyphonyGroupVoiceLimit(L, 8);
+    REQUIRE(vm.setPolyphonyGroupParent(M, P1));
+    REQUIRE(vm.setPolyphonyGroupParent(L, M));
+    REQUIRE(vm.setPolyphonyGroupParent(X, P2));
+    tp.polyGroupForKey = [](int16_t k) -> uint64_t { return k < 30 ? L : X; };
+    auto alive = [&tp](int key)
+    { return tp.activeVoicesMatching([key](auto &v) { return v.key() == key; }) == 1; };
+
+    for (int i = 0; i < 3; ++i)
+        vm.processNoteOnEvent(0, 0, 10 + i, -1, 0.8, 0.0);
+    REQUIRE_VOICE_COUNTS(3, 3);
+
+    // Under P2 the three held voices fill it, so X's first note steals L's oldest
+    REQUIRE(vm.setPolyphonyGroupParent(M, P2));
+    vm.processNoteOnEvent(0, 0, 30, -1, 0.8, 0.0);
+    REQUIRE_VOICE_COUNTS(3, 3);
+    REQUIRE_FALSE(alive(10));
+    REQUIRE(alive(30));
+
+    // As a root only L's own limit binds
+    REQUIRE(vm.setPolyphonyGroupParent(M, vm_t::noPolyphonyGroupParent));
+    for (int i = 3; i < 8; ++i)
+        vm.processNoteOnEvent(0, 0, 10 + i, -1, 0.8, 0.0);
+    REQUIRE_VOICE_COUNTS(8, 8);
+    REQUIRE(tp.activeVoicesMatching([](auto &v) { return v.key() < 30; }) == 7);
+
+    // Back under P1, which is over its limit, so L's next note steals within P1
+    REQUIRE(vm.setPolyphonyGroupParent(M, P1));
+    vm.processNoteOnEvent(0, 0, 18, -1, 0.8, 0.0);
+    REQUIRE_VOICE_COUNTS(8, 8);
+    REQUIRE_FALSE(alive(11));
+    REQUIRE(alive(30));
+
+    // And under P2 again, where X's note takes the oldest of P2's whole subtree
+    REQUIRE(vm.setPolyphonyGroupParent(M, P2));
+    vm.processNoteOnEvent(0, 0, 31, -1, 0.8, 0.0);
+    REQUIRE_VOICE_COUNTS(8, 8);
+    REQUIRE_FALSE(alive(12));
+    REQUIRE(alive(31));
+    REQUIRE(alive(30));
+}
+
+TEST_CASE("Hierarchy - raising a parent limit frees room for every leaf")
+{
+    TestPlayer<32> tp;
+    auto &vm = tp.voiceManager;
+    makeOvercommitTree(tp);
+
+    for (int i = 0; i < 8; ++i)
+        vm.processNoteOnEvent(0, 0, 10 + i, -1, 0.8, 0.0);
+    REQUIRE_VOICE_COUNTS(6, 6); // A's own limit binds first
+
+    // G has room for 2 more, which B takes without stealing
+    vm.processNoteOnEvent(0, 0, 20, -1, 0.8, 0.0);
+    vm.processNoteOnEvent(0, 0, 21, -1, 0.8, 0.0);
+    REQUIRE_VOICE_COUNTS(8, 8);
+
+    // G is full, so C's note steals from the subtree
+    vm.processNoteOnEvent(0, 0, 30, -1, 0.8, 0.0);
+    REQUIRE_VOICE_COUNTS(8, 8);
+    REQUIRE(tp.activeVoicesMatching(inA) == 5);
+
+    // Room at G reaches C, though only G's limit moved
+    vm.setPolyphonyGroupVoiceLimit(G, 12);
+    for (int i = 1; i < 5; ++i)
+        vm.processNoteOnEvent(0, 0, 30 + i, -1, 0.8, 0.0);
+    REQUIRE_VOICE_COUNTS(12, 12);
+    REQUIRE(tp.activeVoicesMatching(inA) == 5);
+    REQUIRE(tp.activeVoicesMatching(inB) == 2);
+    REQUIRE(tp.activeVoicesMatching(inC) == 5);
+}
+
+TEST_CASE("Hierarchy - a limit set, lifted and set again under unlimited leaves")
+{
+    TestPlayer<32> tp;
+    auto &vm = tp.voiceManager;
+    vm.setPolyphonyGroupParent(A, G);
+    vm.setPolyphonyGroupParent(B, G);
+    routeChildrenByKey(tp);
+
+    // Only G is limited; its unlimited leaves share its room
+    vm.setPolyphonyGroupVoiceLimit(G, 4);
+    for (int i = 0; i < 3; ++i)
+        vm.processNoteOnEvent(0, 0, 10 + i, -1, 0.8, 0.0);
+    vm.processNoteOnEvent(0, 0, 20, -1, 0.8, 0.0);
+    vm.processNoteOnEvent(0, 0, 21, -1, 0.8, 0.0);
+    REQUIRE_VOICE_COUNTS(4, 4);
+    REQUIRE(tp.activeVoicesMatching(inA) == 2);
+    REQUIRE(tp.activeVoicesMatching(inB) == 2);
+
+    // Lifting G's limit to the pool leaves nothing limited, so notes just add
+    vm.setPolyphonyGroupVoiceLimit(G, 32);
+    for (int i = 3; i < 7; ++i)
+        vm.processNoteOnEvent(0, 0, 10 + i, -1, 0.8, 0.0);
+    REQUIRE_VOICE_COUNTS(8, 8);
+
+    // A limited leaf under the unlimited G binds on its own
+    vm.setPolyphonyGroupVoiceLimit(A, 5);
+    REQUIRE_VOICE_COUNTS(7, 7);
+    REQUIRE(tp.activeVoicesMatching(inA) == 5);
+    vm.processNoteOnEvent(0, 0, 17, -1, 0.8, 0.0);
+    REQUIRE_VOICE_COUNTS(7, 7);
+    REQUIRE(tp.activeVoicesMatching(inA) == 5);
+    vm.processNoteOnEvent(0, 0, 22, -1, 0.8, 0.0);
+    REQUIRE_VOICE_COUNTS(8, 8);
+
+    // Limiting G again puts both levels on A's chain. G is full with room left in A, so
+    // A's note steals across G's subtree, taking B's oldest
+    vm.setPolyphonyGroupVoiceLimit(A, 6);
+    vm.setPolyphonyGroupVoiceLimit(G, 8);
+    vm.processNoteOnEvent(0, 0, 18, -1, 0.8, 0.0);
+    REQUIRE_VOICE_COUNTS(8, 8);
+    REQUIRE(tp.activeVoicesMatching(inA) == 6);
+    REQUIRE(tp.activeVoicesMatching([](auto &v) { return v.key() == 20; }) == 0);
+}
@@ -63,3 +63,66 @@ TEST_CASE("MIDI1 Note Basics")
         REQUIRE_VOICE_COUNTS(1, 0);
     }
 }
+
+TEST_CASE("MIDI1 Byte Stream")
+{
+    using sst::voicemanager::applyMidi1Stream;
+
+    SECTION("Running Status")
+    {
+        auto tp = TestPlayer<32>();
+        auto &vm = tp.voiceManager;
+
+        // Three note ons under one status byte, then two of them off by velocity 0
+        const uint8_t s[]{0x90, 60, 100, 62, 100, 64, 100, 60, 0, 62, 0};
+        applyMidi1Stream(vm, 0, s, sizeof(s));
+        REQUIRE_VOICE_COUNTS(3, 1);
+        REQUIRE(tp.activeVoicesMatching([](auto &v) { return v.key() == 64 && v.isGated; }) ==
+                1);
+    }
+
+    SECTION("Real Time Bytes Mid Message")
+    {
+        auto tp = TestPlayer<32>();
+        auto &vm = tp.voiceManager;
+
+        const uint8_t s[]{0xF8, 0x90, 0xF8, 60, 0xFE, 127, 0xB2, 7, 0xFA, 88};
+        applyMidi1Stream(vm, 0, s, sizeof(s));
+        REQUIRE_VOICE_COUNTS(1, 1);
+        REQUIRE(tp.midi1CC[2][7] == 88);
+    }
+
+    SECTION("SysEx And System Common Are Skipped")
+    {
+        auto tp = TestPlayer<32>();
+        auto &vm = tp.voiceManager;
+
+        // The SysEx body looks like running status note data, and a song position
+        // pointer cancels the running status, so neither may start a note
+        const uint8_t s[]{0x90, 60,  100, 0xF0, 0x7E, 62, 100, 0xF8, 64,   100, 0xF7,
+                          66,   100, 0xF2, 1,   2,    68, 100, 0x90, 70, 100};
+        applyMidi1Stream(vm, 0, s, sizeof(s));
+        REQUIRE_VOICE_COUNTS(2, 2);
+        REQUIRE(tp.hasKeysActive({60, 70}));
+    }
+
+    SECTION("Messages Split Across Buffers")
+    {
+        auto tp = TestPlayer<32>();
+        auto &vm = tp.voiceManager;
+        sst::voicemanager::Midi1StreamState state;
+
+        const uint8_t a[]{0x91, 60};
+        const uint8_t b[]{100, 62};
+        const uint8_t c[]{100, 0xE1, 0x00};
+        const uint8_t d[]{0x50};
+        applyMidi1Stream(vm, 0, a, sizeof(a), state);
+        REQUIRE_NO_VOICES;
+        applyMidi1Stream(vm, 0, b, sizeof(b), state);
+        REQUIRE_VOICE_COUNTS(1, 1);
+        applyMidi1Stream(vm, 0, c, sizeof(c), state);
+        REQUIRE_VOICE_COUNTS(2, 2);
+        applyMidi1Stream(vm, 0, d, sizeof(d), state);
+        REQUIRE(tp.pitchBend[1] == 0x50 * 128);
+    }
+}
@@ -642,3 +642,68 @@ TEST_CASE("Mono Mode - Layerd Retrigger Miss")
     REQUIRE_KEY_COUNT(1, 58);
     REQUIRE_KEY_COUNT(2, 60);
 }
+
+struct TwoHeldKeyStatesCfg
+{
+    static constexpr size_t maxHeldKeyStateCount{2};
+};
+
+TEST_CASE("Mono Mode - Held Keys Past The Key State Pool")
+{
+    using tp_t = TestPlayer<32, false, TwoHeldKeyStatesCfg>;
+    auto tp = tp_t();
+    typedef tp_t::voiceManager_t vm_t;
+    auto &vm = tp.voiceManager;
+
+    // Legato moves the one voice between keys, so it is never retriggered
+    bool legato{false};
+    SECTION("Natural Mono")
+    {
+        vm.setPlaymode(0, vm_t::PlayMode::MONO_NOTES,
+                       (uint64_t)vm_t::MonoPlayModeFeatures::NATURAL_MONO);
+    }
+    SECTION("Natural Legato")
+    {
+        legato = true;
+        vm.setPlaymode(0, vm_t::PlayMode::MONO_NOTES,
+                       (uint64_t)vm_t::MonoPlayModeFeatures::NATURAL_LEGATO);
+    }
+    auto onKey = [legato](int k)
+    { return [=](auto &v) { return v.key() == k && (!legato || v.creationCount == 1); }; };
+
+    INFO("Three keys down with room to record two; the third still plays");
+    for (int k : {60, 62, 64})
+    {
+        vm.processNoteOnEvent(0, 0, k, -1, 0.8, 0.0);
+        REQUIRE_VOICE_COUNTS(1, 1);
+        REQUIRE_VOICE_MATCH_FN(1, onKey(k));
+    }
+
+    INFO("Releasing the unrecorded key returns to the latest recorded one");
+    vm.processNoteOffEvent(0, 0, 64, -1, 0.0);
+    REQUIRE_VOICE_COUNTS(1, 1);
+    REQUIRE_VOICE_MATCH_FN(1, onKey(62));
+
+    vm.processNoteOffEvent(0, 0, 62, -1, 0.0);
+    REQUIRE_VOICE_COUNTS(1, 1);
+    REQUIRE_VOICE_MATCH_FN(1, onKey(60));
+
+    INFO("Released keys give their records back to the pool");
+    vm.processNoteOnEvent(0, 0, 65, -1, 0.8, 0.0);
+    vm.processNoteOnEvent(0, 0, 67, -1, 0.8, 0.0);
+    REQUIRE_VOICE_COUNTS(1, 1);
+    REQUIRE_VOICE_MATCH_FN(1, onKey(67));
+
+    vm.processNoteOffEvent(0, 0, 60, -1, 0.0);
+    REQUIRE_VOICE_COUNTS(1, 1);
+    REQUIRE_VOICE_MATCH_FN(1, onKey(67));
+
+    vm.processNoteOffEvent(0, 0, 67, -1, 0.0);
+    REQUIRE_VOICE_COUNTS(1, 1);
+    REQUIRE_VOICE_MATCH_FN(1, onKey(65));
+
+    vm.processNoteOffEvent(0, 0, 65, -1, 0.0);
+    REQUIRE_VOICE_COUNTS(1, 0);
+    tp.processFor(10);
+    REQUIRE_NO_VOICES;
+}
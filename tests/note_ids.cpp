@@ -406,9 +406,9 @@ TEST_CASE("Note ID On Off works in Mono Modes")
 TEST_CASE("Note ID Stack 128 Key Smoke Test")
 {
     /*
-     * VoiceInfo::noteIdStack is a fixed std::array<int32_t, 256>.
-     * Standard MIDI has 128 keys per channel (0-127), so you can never exceed 128
-     * simultaneous held keys on one channel - well within the 256-entry limit.
+     * A voice keeps its newest few note ids inline and spills older ones to a shared
+     * overflow set (256 entries by default). Standard MIDI has 128 keys per channel
+     * (0-127), so one legato voice can never need more than 128 ids on one channel.
      * This test presses all 128 keys in MONO_LEGATO mode and verifies no crash,
      * exactly 1 gated voice throughout, and clean teardown on release.
      */
@@ -482,4 +482,167 @@ TEST_CASE("That Six Sines VST3 Case")
             tp.processFor(2);
         }
     }
-}
\ No newline at end of file
+}
+
+struct SmallNoteIdStackCfg
+{
+    static constexpr size_t noteIdStackSize{2};
+    static constexpr size_t noteIdOverflowCount{4};
+};
+
+TEST_CASE("Note ID Stack Overflow")
+{
+    /*
+     * With two ids inline per voice and four shared overflow entries, a piano mode voice
+     * restruck on one key pushes its older ids into the overflow set, where they still
+     * address the voice. Once the overflow is full a further push forgets the oldest id.
+     */
+    typedef TestPlayer<32, false, SmallNoteIdStackCfg> player_t;
+    typedef player_t::voiceManager_t vm_t;
+    typedef player_t::Voice vc_t;
+
+    auto exprOn = [](auto &tp, int16_t key, int32_t e)
+    {
+        return tp.activeVoicesMatching(
+            [=](const vc_t &v)
+            {
+                auto it = v.noteExpressionCache.find(e);
+                return v.key() == key && it != v.noteExpressionCache.end() && it->second == 0.5;
+            });
+    };
+
+    // Strike key with each note id in turn, leaving it held by the last
+    auto strike = [](vm_t &vm, int16_t key, std::initializer_list<int32_t> nids)
+    {
+        auto last = *(nids.end() - 1);
+        for (auto nid : nids)
+        {
+            vm.processNoteOnEvent(0, 0, key, nid, 0.8, 0.0);
+            if (nid != last)
+                vm.processNoteOffEvent(0, 0, key, nid, 0.8);
+        }
+    };
+
+    SECTION("Overflowed ids answer expressions and note offs")
+    {
+        auto tp = player_t();
+        vm_t &vm = tp.voiceManager;
+        vm.repeatedKeyMode = vm_t::RepeatedKeyMode::PIANO;
+
+        strike(vm, 60, {1, 2, 3, 4});
+        REQUIRE_VOICE_COUNTS(1, 1);
+        REQUIRE_VOICE_MATCH(1, v.key() == 60 && v.noteid() == 4);
+
+        for (int32_t nid = 1; nid <= 4; ++nid)
+        {
+            INFO("Expression on note id " << nid);
+            vm.routeNoteExpression(0, 0, 60, nid, nid, 0.5);
+            REQUIRE(exprOn(tp, 60, nid) == 1);
+        }
+        vm.routeNoteExpression(0, 0, 60, 5, 5, 0.5);
+        REQUIRE(exprOn(tp, 60, 5) == 0);
+
+        INFO("A note off by the oldest, overflowed, id still releases the voice");
+        vm.processNoteOffEvent(0, 0, 60, 1, 0.8);
+        REQUIRE_VOICE_COUNTS(1, 0);
+        tp.processFor(10);
+        REQUIRE_NO_VOICES;
+    }
+
+    SECTION("A full overflow forgets the oldest id")
+    {
+        auto tp = player_t();
+        vm_t &vm = tp.voiceManager;
+        vm.repeatedKeyMode = vm_t::RepeatedKeyMode::PIANO;
+
+        strike(vm, 60, {1, 2, 3, 4, 5, 6});
+        strike(vm, 62, {11, 12, 13});
+        REQUIRE_VOICE_COUNTS(2, 2);
+
+        for (int32_t nid : {1, 2, 3, 4, 5, 6})
+        {
+            INFO("Expression on note id " << nid);
+            vm.routeNoteExpression(0, 0, -1, nid, nid, 0.5);
+            REQUIRE(exprOn(tp, 60, nid) == 1);
+        }
+        vm.routeNoteExpression(0, 0, -1, 11, 11, 0.5);
+        REQUIRE(exprOn(tp, 62, 11) == 0);
+        for (int32_t nid : {12, 13})
+        {
+            INFO("Expression on note id " << nid);
+            vm.routeNoteExpression(0, 0, -1, nid, nid, 0.5);
+            REQUIRE(exprOn(tp, 62, nid) == 1);
+        }
+
+        INFO("Ending the first voice frees its overflow entries for the second");
+        vm.processNoteOffEvent(0, 0, 60, 6, 0.8);
+        tp.processFor(10);
+        REQUIRE_VOICE_COUNTS(1, 1);
+        vm.processNoteOffEvent(0, 0, 62, 13, 0.8);
+        strike(vm, 62, {14});
+        vm.routeNoteExpression(0, 0, -1, 12, 112, 0.5);
+        REQUIRE(exprOn(tp, 62, 112) == 1);
+        vm.processNoteOffEvent(0, 0, 62, 12, 0.8);
+        REQUIRE_VOICE_COUNTS(1, 0);
+    }
+
+    SECTION("Legato release drops the released id but keeps overflowed ones")
+    {
+        auto tp = player_t();
+        vm_t &vm = tp.voiceManager;
+        vm.setPlaymode(0, vm_t::PlayMode::MONO_NOTES,
+                       (uint64_t)vm_t::MonoPlayModeFeatures::NATURAL_LEGATO);
+
+        vm.processNoteOnEvent(0, 0, 60, 1, 0.8, 0.0);
+        vm.processNoteOnEvent(0, 0, 62, 2, 0.8, 0.0);
+        vm.processNoteOnEvent(0, 0, 64, 3, 0.8, 0.0);
+        REQUIRE_VOICE_COUNTS(1, 1);
+        REQUIRE_VOICE_MATCH(1, v.key() == 64);
+
+        vm.processNoteOffEvent(0, 0, 64, 3, 0.8);
+        REQUIRE_VOICE_COUNTS(1, 1);
+        REQUIRE_VOICE_MATCH(1, v.key() == 62);
+
+        vm.routeNoteExpression(0, 0, -1, 3, 3, 0.5);
+        REQUIRE(exprOn(tp, 62, 3) == 0);
+        for (int32_t nid : {1, 2})
+        {
+            INFO("Expression on note id " << nid);
+            vm.routeNoteExpression(0, 0, -1, nid, nid, 0.5);
+            REQUIRE(exprOn(tp, 62, nid) == 1);
+        }
+
+        vm.processNoteOffEvent(0, 0, 62, 2, 0.8);
+        REQUIRE_VOICE_COUNTS(1, 1);
+        REQUIRE_VOICE_MATCH(1, v.key() == 60);
+
+        INFO("Only the overflowed id of the first note is left, and it still releases");
+        vm.processNoteOffEvent(0, 0, 60, 1, 0.8);
+        REQUIRE_VOICE_COUNTS(1, 0);
+        tp.processFor(10);
+        REQUIRE_NO_VOICES;
+    }
+
+    SECTION("A mono retrigger starts with a fresh note id stack")
+    {
+        auto tp = player_t();
+        vm_t &vm = tp.voiceManager;
+        vm.setPlaymode(0, vm_t::PlayMode::MONO_NOTES,
+                       (uint64_t)vm_t::MonoPlayModeFeatures::NATURAL_MONO);
+
+        vm.processNoteOnEvent(0, 0, 60, 1, 0.8, 0.0);
+        vm.processNoteOnEvent(0, 0, 62, 2, 0.8, 0.0);
+        REQUIRE_VOICE_COUNTS(1, 1);
+        REQUIRE_VOICE_MATCH(1, v.key() == 62 && v.noteid() == 2);
+
+        vm.processNoteOffEvent(0, 0, 62, 2, 0.8);
+        REQUIRE_VOICE_COUNTS(1, 1);
+        REQUIRE_VOICE_MATCH(1, v.key() == 60 && v.noteid() == -1);
+
+        INFO("The retriggered voice carries no note id, so an off for its key by any id ends it");
+        vm.processNoteOffEvent(0, 0, 60, 1, 0.8);
+        REQUIRE_VOICE_COUNTS(1, 0);
+        tp.processFor(10);
+        REQUIRE_NO_VOICES;
+    }
+}
@@ -0,0 +1,176 @@
+/*
+ * sst-voicemanager - a header only library providing synth
+ * voice management in response to midi and clap event streams
+ * with support for a variety of play, trigger, and midi nodes
+ *
+ * Copyright 2023-2024, various authors, as described in the GitHub
+ * transaction log.
+ *
+ * sst-voicemanager is released under the MIT license, available
+ * as LICENSE.md in the root of this repository.
+ *
+ * All source in sst-voicemanager available at
+ * https://github.com/surge-synthesizer/sst-voicemanager
+ */
+
+#include "catch2.hpp"
+
+#include <vector>
+
+#include "sst/voicemanager/voicemanager.h"
+#include "test_player.h"
+
+using ev_t = sst::voicemanager::VoiceEvent;
+
+namespace
+{
+std::vector<ev_t> denseBlock()
+{
+    std::vector<ev_t> res;
+    for (int i = 0; i < 6; ++i)
+        res.push_back(ev_t::noteOn(i * 4, 0, 0, 60 + i, 1000 + i, 0.8f));
+    res.push_back(ev_t::midi1CC(30, 0, 0, 7, 100));
+    res.push_back(ev_t::pitchBend(31, 0, 0, 9000));
+    res.push_back(ev_t::channelPressure(32, 0, 0, 44));
+    res.push_back(ev_t::polyphonicAftertouch(33, 0, 0, 61, 77));
+    res.push_back(ev_t::noteExpression(34, 0, 0, 62, 1002, 3, 0.25));
+    res.push_back(ev_t::sustainPedal(40, 0, 0, 127));
+    res.push_back(ev_t::noteOff(41, 0, 0, 60, 1000, 0.5f));
+    res.push_back(ev_t::noteOff(42, 0, 0, 61, 1001, 0.5f));
+    res.push_back(ev_t::monophonicParameterModulation(50, 0, 0, -1, 12, 0.5));
+    res.push_back(ev_t::noteOn(64, 0, 0, 80, 2000, 0.7f));
+    res.push_back(ev_t::sustainPedal(70, 0, 0, 0));
+    res.push_back(ev_t::noteOff(90, 0, 0, 62, 1002, 0.5f));
+    return res;
+}
+
+void playOneAtATime(TestPlayer<32> &tp)
+{
+    auto &vm = tp.voiceManager;
+    for (int i = 0; i < 6; ++i)
+        vm.processNoteOnEvent(0, 0, 60 + i, 1000 + i, 0.8f, 0.f);
+    vm.routeMIDI1CC(0, 0, 7, 100);
+    vm.routeMIDIPitchBend(0, 0, 9000);
+    vm.routeChannelPressure(0, 0, 44);
+    vm.routePolyphonicAftertouch(0, 0, 61, 77);
+    vm.routeNoteExpression(0, 0, 62, 1002, 3, 0.25);
+    vm.updateSustainPedal(0, 0, 127);
+    vm.processNoteOffEvent(0, 0, 60, 1000, 0.5f);
+    vm.processNoteOffEvent(0, 0, 61, 1001, 0.5f);
+    vm.routeMonophonicParameterModulation(0, 0, -1, 12, 0.5);
+    vm.processNoteOnEvent(0, 0, 80, 2000, 0.7f, 0.f);
+    vm.updateSustainPedal(0, 0, 0);
+    vm.processNoteOffEvent(0, 0, 62, 1002, 0.5f);
+}
+
+void requireSameState(const TestPlayer<32> &a, const TestPlayer<32> &b)
+{
+    REQUIRE(a.getActiveVoicePCKNS() == b.getActiveVoicePCKNS());
+    REQUIRE(a.getGatedVoicePCKNS() == b.getGatedVoicePCKNS());
+    for (size_t i = 0; i < a.voiceStorage.size(); ++i)
+    {
+        const auto &va = a.voiceStorage[i];
+        const auto &vb = b.voiceStorage[i];
+        REQUIRE(va.polyATValue == vb.polyATValue);
+        REQUIRE(va.noteExpressionCache == vb.noteExpressionCache);
+        REQUIRE(va.monoParamModulationCache == vb.monoParamModulationCache);
+    }
+    REQUIRE(a.midi1CC == b.midi1CC);
+    REQUIRE(a.pitchBend == b.pitchBend);
+    REQUIRE(a.channelPressure == b.channelPressure);
+}
+} // namespace
+
+TEST_CASE("Process Events Matches One Call Per Event")
+{
+    TestPlayer<32> viaBlock, viaCalls;
+    auto block = denseBlock();
+
+    REQUIRE(viaBlock.voiceManager.processEvents(block) == block.size());
+    playOneAtATime(viaCalls);
+
+    // Key 80 launches three voices; 60 to 62 are released but not yet rendered out
+    REQUIRE(viaBlock.voiceManager.getVoiceCount() == 9);
+    REQUIRE(viaBlock.voiceManager.getGatedVoiceCount() == 6);
+    requireSameState(viaBlock, viaCalls);
+}
+
+TEST_CASE("Process Events Stops At The Split Point")
+{
+    TestPlayer<32> viaSplits, viaCalls;
+    auto &vm = viaSplits.voiceManager;
+    auto block = denseBlock();
+    std::span<const ev_t> rest{block};
+
+    // Render in sub-blocks ending at 32 and 64, then the tail
+    auto done = vm.processEvents(rest, 32);
+    REQUIRE(done == 8);
+    REQUIRE(vm.getVoiceCount() == 6);
+    rest = rest.subspan(done);
+
+    done = vm.processEvents(rest, 64);
+    REQUIRE(done == 7);
+    REQUIRE(vm.getGatedVoiceCount() == 6); // 60 and 61 are held by the pedal
+    rest = rest.subspan(done);
+
+    REQUIRE(vm.processEvents(rest, 64) == 0);
+    REQUIRE(vm.processEvents(rest) == rest.size());
+
+    playOneAtATime(viaCalls);
+    requireSameState(viaSplits, viaCalls);
+}
+
+TEST_CASE("Process Events Coalesces Controllers Per Offset")
+{
+    TestPlayer<32> tp;
+    auto &vm = tp.voiceManager;
+    std::vector<ev_t> block;
+    for (int i = 0; i < 3; ++i)
+        block.push_back(ev_t::pitchBend(10, 0, 0, 8000 + i * 100));
+    block.push_back(ev_t::midi1CC(10, 0, 0, 7, 1));
+    block.push_back(ev_t::midi1CC(10, 0, 0, 7, 2));
+    block.push_back(ev_t::pitchBend(20, 0, 0, 9000));
+    block.push_back(ev_t::pitchBend(20, 0, 0, 9100));
+    block.push_back(ev_t::noteOn(30, 0, 1, 60, 1000, 0.8f));
+    std::span<const ev_t> rest{block};
+
+    // The three bends at 10 reach the responder once, stamped 10, as the block leaves 10
+    auto done = vm.processEvents(rest, 20);
+    REQUIRE(done == 5);
+    REQUIRE(tp.pitchBendUpdates == 1);
+    REQUIRE(tp.pitchBend[0] == 8200);
+    REQUIRE(tp.midi1CC[0][7] == 2);
+    REQUIRE(tp.monoCoalescedOffset == 10);
+    rest = rest.subspan(done);
+
+    REQUIRE(vm.processEvents(rest) == rest.size());
+    REQUIRE(tp.pitchBendUpdates == 2);
+    REQUIRE(tp.pitchBend[0] == 9100);
+    REQUIRE(tp.monoCoalescedOffset == 20);
+    REQUIRE(vm.getVoiceCount() == 1);
+
+    // Outside a block, with coalesceControllers off, each bend still goes out at once
+    vm.routeMIDIPitchBend(0, 0, 100);
+    vm.routeMIDIPitchBend(0, 0, 200);
+    REQUIRE(tp.pitchBendUpdates == 4);
+}
+
+TEST_CASE("Process Events Routes Keyed Polyphonic Modulation")
+{
+    TestPlayer<32> tp;
+    auto &vm = tp.voiceManager;
+    std::vector<ev_t> block{ev_t::noteOn(0, 0, 0, 60, 1000, 0.8f),
+                            ev_t::noteOn(0, 0, 0, 62, 1001, 0.8f),
+                            ev_t::keyedPolyphonicParameterModulation(8, 0, 0, 62, 12, 0.25)};
+
+    REQUIRE(vm.processEvents(block) == block.size());
+    REQUIRE(tp.activeVoicesMatching(
+                [](auto &v)
+                {
+                    auto it = v.paramModulationCache.find(12);
+                    return v.key() == 62 && it != v.paramModulationCache.end() &&
+                           it->second == 0.25;
+                }) == 1);
+    REQUIRE(tp.activeVoicesMatching([](auto &v) { return v.paramModulationCache.empty(); }) ==
+            1);
+}
@@ -159,6 +159,113 @@ TEST_CASE("Routing Poly AT")
     REQUIRE(tp.activeVoicesMatching([](auto &v) { return v.polyATValue == 23; }) == 3);
 }
 
+TEST_CASE("Routing Poly AT Across Voice Lifetimes")
+{
+    typedef TestPlayer<32>::voiceManager_t vm_t;
+
+    SECTION("Note Off And Sustain Release")
+    {
+        auto tp = TestPlayer<32>();
+        auto &vm = tp.voiceManager;
+
+        vm.updateSustainPedal(0, 0, 127);
+        vm.processNoteOnEvent(0, 0, 55, -1, 0.5, 0);
+        vm.processNoteOnEvent(0, 0, 57, -1, 0.5, 0);
+        vm.processNoteOffEvent(0, 0, 55, -1, 0.5);
+        tp.processFor(10);
+        REQUIRE_VOICE_COUNTS(2, 2);
+
+        // The sustained voice still answers on its key
+        vm.routePolyphonicAftertouch(0, 0, 55, 17);
+        REQUIRE(tp.activeVoicesMatching([](auto &v) { return v.polyATValue == 17; }) == 1);
+        REQUIRE(tp.activeVoiceCheck([](auto &v) { return v.key() == 55; },
+                                    [](auto &v) { return v.polyATValue == 17; }));
+
+        vm.updateSustainPedal(0, 0, 0);
+        REQUIRE_VOICE_COUNTS(2, 1);
+        tp.processFor(10);
+        REQUIRE_VOICE_COUNTS(1, 1);
+
+        // A new key in the freed slot answers on its own key and not on the old one
+        vm.processNoteOnEvent(0, 0, 60, -1, 0.5, 0);
+        REQUIRE_VOICE_COUNTS(2, 2);
+        vm.routePolyphonicAftertouch(0, 0, 55, 23);
+        REQUIRE(tp.activeVoicesMatching([](auto &v) { return v.polyATValue == 23; }) == 0);
+        vm.routePolyphonicAftertouch(0, 0, 60, 31);
+        REQUIRE(tp.activeVoicesMatching([](auto &v) { return v.polyATValue == 31; }) == 1);
+        REQUIRE(tp.activeVoiceCheck([](auto &v) { return v.key() == 60; },
+                                    [](auto &v) { return v.polyATValue == 31; }));
+    }
+
+    SECTION("Steal")
+    {
+        auto tp = TestPlayer<4>();
+        auto &vm = tp.voiceManager;
+
+        for (auto k : {50, 52, 54, 56})
+        {
+            vm.processNoteOnEvent(0, 0, k, -1, 0.5, 0);
+            tp.processFor(2);
+        }
+        REQUIRE_VOICE_COUNTS(4, 4);
+
+        vm.processNoteOnEvent(0, 0, 58, -1, 0.5, 0);
+        REQUIRE_VOICE_COUNTS(4, 4);
+        REQUIRE_KEY_COUNT(0, 50);
+
+        vm.routePolyphonicAftertouch(0, 0, 50, 17);
+        REQUIRE(tp.activeVoicesMatching([](auto &v) { return v.polyATValue == 17; }) == 0);
+        vm.routePolyphonicAftertouch(0, 0, 58, 23);
+        REQUIRE(tp.activeVoicesMatching([](auto &v) { return v.polyATValue == 23; }) == 1);
+        REQUIRE(tp.activeVoiceCheck([](auto &v) { return v.key() == 58; },
+                                    [](auto &v) { return v.polyATValue == 23; }));
+    }
+
+    SECTION("Piano Mode Retrigger")
+    {
+        auto tp = TestPlayer<32>();
+        auto &vm = tp.voiceManager;
+        vm.repeatedKeyMode = vm_t::RepeatedKeyMode::PIANO;
+
+        vm.processNoteOnEvent(0, 0, 55, -1, 0.5, 0);
+        vm.processNoteOffEvent(0, 0, 55, -1, 0.5);
+        tp.processFor(2);
+        vm.processNoteOnEvent(0, 0, 55, -1, 0.5, 0);
+        REQUIRE_VOICE_COUNTS(1, 1);
+
+        vm.routePolyphonicAftertouch(0, 0, 55, 17);
+        REQUIRE(tp.activeVoicesMatching([](auto &v) { return v.polyATValue == 17; }) == 1);
+    }
+
+    SECTION("Legato Move")
+    {
+        auto tp = TestPlayer<32>();
+        auto &vm = tp.voiceManager;
+        vm.setPlaymode(0, vm_t::PlayMode::MONO_NOTES,
+                       static_cast<uint64_t>(vm_t::MonoPlayModeFeatures::NATURAL_LEGATO));
+
+        vm.processNoteOnEvent(0, 0, 55, -1, 0.5, 0);
+        tp.processFor(2);
+        vm.processNoteOnEvent(0, 0, 60, -1, 0.5, 0);
+        REQUIRE_VOICE_COUNTS(1, 1);
+        REQUIRE_KEY_COUNT(1, 60);
+
+        // The moved voice answers on the key it moved to
+        vm.routePolyphonicAftertouch(0, 0, 55, 17);
+        REQUIRE(tp.activeVoicesMatching([](auto &v) { return v.polyATValue == 17; }) == 0);
+        vm.routePolyphonicAftertouch(0, 0, 60, 23);
+        REQUIRE(tp.activeVoicesMatching([](auto &v) { return v.polyATValue == 23; }) == 1);
+
+        // and back on the held key once the top note is released
+        vm.processNoteOffEvent(0, 0, 60, -1, 0.5);
+        REQUIRE_KEY_COUNT(1, 55);
+        vm.routePolyphonicAftertouch(0, 0, 60, 31);
+        REQUIRE(tp.activeVoicesMatching([](auto &v) { return v.polyATValue == 31; }) == 0);
+        vm.routePolyphonicAftertouch(0, 0, 55, 37);
+        REQUIRE(tp.activeVoicesMatching([](auto &v) { return v.polyATValue == 37; }) == 1);
+    }
+}
+
 TEST_CASE("Routing Note Expressions")
 {
     auto tp = TestPlayer<32>();
@@ -426,6 +533,52 @@ TEST_CASE("Routing Poly Parameter Modulations")
                                 [](auto &v) { return v.paramModulationCache.at(2) == -0.33; }));
 }
 
+TEST_CASE("Routing Poly Parameter Modulations Without A Voice Id")
+{
+    SECTION("Voice Id -1 Reaches Every Voice")
+    {
+        auto tp = TestPlayer<32>();
+        auto &vm = tp.voiceManager;
+
+        vm.processNoteOnEvent(0, 0, 55, 10455, 0.5, 0);
+        vm.processNoteOnEvent(0, 1, 60, 10460, 0.5, 0);
+        REQUIRE_VOICE_COUNTS(2, 2);
+
+        vm.routePolyphonicParameterModulation(0, 0, 55, -1, 4, 0.5);
+        REQUIRE(tp.activeVoicesMatching([](auto &v)
+                                        { return v.paramModulationCache.at(4) == 0.5; }) == 2);
+    }
+
+    SECTION("Keyed Modulation Reaches The Voices On That Key")
+    {
+        auto tp = TestPlayer<32>();
+        auto &vm = tp.voiceManager;
+
+        vm.processNoteOnEvent(0, 0, 55, 10455, 0.5, 0);
+        vm.processNoteOnEvent(0, 0, 55, 20455, 0.5, 0);
+        vm.processNoteOnEvent(0, 1, 55, 30455, 0.5, 0);
+        vm.processNoteOnEvent(0, 0, 60, 10460, 0.5, 0);
+        REQUIRE_VOICE_COUNTS(4, 4);
+
+        vm.routeKeyedPolyphonicParameterModulation(0, 0, 55, 4, 0.5);
+        REQUIRE(tp.activeVoicesMatching([](auto &v)
+                                        { return v.paramModulationCache.count(4) == 1; }) == 2);
+        REQUIRE(tp.activeVoicesMatching(
+                    [](auto &v)
+                    {
+                        return v.key() == 55 && v.channel() == 0 &&
+                               v.paramModulationCache.at(4) == 0.5;
+                    }) == 2);
+
+        // A wildcard channel takes in the voice on channel 1 as well
+        vm.routeKeyedPolyphonicParameterModulation(0, -1, 55, 5, 0.25);
+        REQUIRE(tp.activeVoicesMatching([](auto &v)
+                                        { return v.paramModulationCache.count(5) == 1; }) == 3);
+        REQUIRE(tp.activeVoicesMatching([](auto &v)
+                                        { return v.monoParamModulationCache.empty(); }) == 4);
+    }
+}
+
 TEST_CASE("Routing Mono Parameter Modulations")
 {
     INFO("routeMonophonicParameterModulation delivers to all active voices regardless of "
@@ -532,4 +532,56 @@ TEST_CASE("Cross-Group Steal Honors Requesting Group Priority")
         REQUIRE(tp.activeVoicesMatching([](auto &v) { return v.key() == 60; }) == 0);
         REQUIRE(tp.activeVoicesMatching([](auto &v) { return v.key() == 70; }) == 1);
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("Unguaranteed Group Plays In The Default Group")
+{
+    INFO("A group nobody guaranteed answers the defaults, and a note naming it plays in group "
+         "0 rather than have note on add the group.");
+    TestPlayer<32, false> tp;
+    auto &vm = tp.voiceManager;
+    typedef TestPlayer<32, false>::voiceManager_t vm_t;
+
+    REQUIRE(vm.getPolyphonyGroupVoiceLimit(7) == 32);
+    REQUIRE(vm.getPlaymode(7) == vm_t::PlayMode::POLY_VOICES);
+
+    vm.setPolyphonyGroupVoiceLimit(0, 3);
+    tp.polyGroupForKey = [](auto k) { return (k < 60 ? 0 : 7); };
+    for (int i = 0; i < 4; ++i)
+        vm.processNoteOnEvent(0, 0, 60 + i, -1, 0.8, 0.0);
+    REQUIRE_VOICE_COUNTS(3, 3);
+
+    // Group 0's own notes share that budget
+    vm.processNoteOnEvent(0, 0, 50, -1, 0.8, 0.0);
+    REQUIRE_VOICE_COUNTS(3, 3);
+    REQUIRE(tp.activeVoicesMatching([](auto &v) { return v.key() == 50; }) == 1);
+    REQUIRE(vm.getPolyphonyGroupVoiceLimit(7) == 32);
+}
+
+struct TwoGroupCfg
+{
+    static constexpr size_t maxPolyphonyGroupCount{2};
+};
+
+TEST_CASE("Group Table Full")
+{
+    INFO("Past maxPolyphonyGroupCount a new group is ignored by the setters and its voices "
+         "play in the default group.");
+    TestPlayer<32, false, TwoGroupCfg> tp;
+    auto &vm = tp.voiceManager;
+
+    vm.setPolyphonyGroupVoiceLimit(1, 2);
+    vm.setPolyphonyGroupVoiceLimit(2, 1);
+    REQUIRE(vm.getPolyphonyGroupVoiceLimit(1) == 2);
+    REQUIRE(vm.getPolyphonyGroupVoiceLimit(2) == 32);
+    REQUIRE_FALSE(vm.setPolyphonyGroupParent(2, 1));
+    REQUIRE_FALSE(vm.setPolyphonyGroupParent(1, 2));
+
+    tp.polyGroupForKey = [](auto k) { return (k < 60 ? 1 : 2); };
+    for (int i = 0; i < 3; ++i)
+        vm.processNoteOnEvent(0, 0, 50 + i, -1, 0.8, 0.0);
+    for (int i = 0; i < 3; ++i)
+        vm.processNoteOnEvent(0, 0, 60 + i, -1, 0.8, 0.0);
+    REQUIRE_VOICE_COUNTS(5, 5);
+    REQUIRE(tp.activeVoicesMatching([](auto &v) { return v.key() >= 60; }) == 3);
+}
@@ -180,4 +180,57 @@ TEST_CASE("Stealing Prefers Releasing Voices Before Gated")
     SECTION("Under OLDEST priority") { runWith(vm_t::StealingPriorityMode::OLDEST); }
     SECTION("Under HIGHEST priority") { runWith(vm_t::StealingPriorityMode::HIGHEST); }
     SECTION("Under LOWEST priority") { runWith(vm_t::StealingPriorityMode::LOWEST); }
-}
\ No newline at end of file
+}
+
+struct PreferRecentlyFreedCfg
+{
+    static constexpr bool preferRecentlyFreedVoiceSlots{true};
+};
+
+TEST_CASE("Stealing Ties Follow Voice Slot Reuse")
+{
+    INFO("Equal keys steal from the lower voice slot first, which shows where a voice was "
+         "placed. Free slots 1 then 3, then place two voices on the same key: by default they "
+         "take the lowest free slot, so the first lands in slot 1, while preferring recently "
+         "freed slots puts the first in slot 3.");
+
+    auto runWith = [](auto &tp, int32_t expectStolen, int32_t expectKept)
+    {
+        using vm_t = typename std::remove_reference_t<decltype(tp)>::voiceManager_t;
+        auto &vm = tp.voiceManager;
+        vm.setPolyphonyGroupVoiceLimit(0, 4);
+        vm.setStealingPriorityMode(0, vm_t::StealingPriorityMode::LOWEST);
+
+        for (int nid = 1; nid <= 4; ++nid)
+            vm.processNoteOnEvent(0, 0, 70, nid, 0.8, 0.0);
+        REQUIRE_VOICE_COUNTS(4, 4);
+
+        vm.processNoteOffEvent(0, 0, 70, 2, 0.8);
+        tp.processFor(10);
+        vm.processNoteOffEvent(0, 0, 70, 4, 0.8);
+        tp.processFor(10);
+        REQUIRE_VOICE_COUNTS(2, 2);
+
+        vm.processNoteOnEvent(0, 0, 60, 5, 0.8, 0.0);
+        vm.processNoteOnEvent(0, 0, 60, 6, 0.8, 0.0);
+        REQUIRE_VOICE_COUNTS(4, 4);
+
+        vm.processNoteOnEvent(0, 0, 72, 7, 0.8, 0.0);
+        REQUIRE_VOICE_COUNTS(4, 4);
+        REQUIRE(tp.activeVoicesMatching([=](auto &v) { return v.noteid() == expectStolen; }) ==
+                0);
+        REQUIRE(tp.activeVoicesMatching([=](auto &v) { return v.noteid() == expectKept; }) == 1);
+        REQUIRE(tp.activeVoicesMatching([](auto &v) { return v.noteid() == 7; }) == 1);
+    };
+
+    SECTION("Lowest free slot by default")
+    {
+        TestPlayer<32> tp;
+        runWith(tp, 5, 6);
+    }
+    SECTION("Most recently freed slot when asked")
+    {
+        TestPlayer<32, false, PreferRecentlyFreedCfg> tp;
+        runWith(tp, 6, 5);
+    }
+}
@@ -26,6 +26,7 @@
 #include <tuple>
 #include <sstream>
 #include <map>
+#include <unordered_set>
 
 #include "sst/voicemanager/voicemanager.h"
 #include <algorithm>
@@ -47,7 +48,16 @@
  * This test player has the feature that it makes one voice for a note in range 0..72 and 3 voices
  * per note over 72. A released voice fades over 5 calls to process then terminates
  */
-template <size_t voiceCount, bool doLog = false> struct TestPlayer
+/*
+ * Optional Cfg settings (maxHeldKeyStateCount, noteIdStackSize and friends) a test can mix into
+ * the TestPlayer's Config to run the voice manager with something other than the defaults.
+ */
+struct DefaultTestCfg
+{
+};
+
+template <size_t voiceCount, bool doLog = false, typename ExtraCfg = DefaultTestCfg>
+struct TestPlayer
 {
     using pckn_t = std::tuple<int16_t, int16_t, int16_t, int32_t>;
     int32_t lastCreationCount{1};
@@ -93,7 +103,7 @@ template <size_t voiceCount, bool doLog = false> struct TestPlayer
         int8_t mpePressure{0}, mpeTimbre{0};
     };
 
-    struct Config
+    struct Config : ExtraCfg
     {
         using voice_t = Voice;
         static constexpr size_t maxVoiceCount{voiceCount};
@@ -230,6 +240,7 @@ template <size_t voiceCount, bool doLog = false> struct TestPlayer
             TPF;
             testPlayer.terminatedVoiceSet.insert(voiceId);
         }
+        void setCoalescedControllerOffset(uint32_t o) { testPlayer.coalescedOffset = o; }
 
     } responder;
 
@@ -323,6 +334,7 @@ template <size_t voiceCount, bool doLog = false> struct TestPlayer
         void setMIDIPitchBend(int16_t channel, int16_t pb14bit)
         {
             testPlayer.pitchBend[std::clamp(channel, (int16_t)0, (int16_t)15)] = pb14bit;
+            testPlayer.pitchBendUpdates++;
         }
         void setMIDI1CC(int16_t channel, int16_t cc, int8_t val)
         {
@@ -334,9 +346,13 @@ template <size_t voiceCount, bool doLog = false> struct TestPlayer
             assert(channel >= 0 && channel < 16);
             testPlayer.channelPressure[std::clamp(channel, (int16_t)0, (int16_t)15)] = pres;
         }
+        void setCoalescedControllerOffset(uint32_t o) { testPlayer.monoCoalescedOffset = o; }
     } monoResponder;
 
     std::array<int16_t, 16> channelPressure{}, pitchBend{};
+    int pitchBendUpdates{0};
+    // The offset each responder last heard from a coalesced controller flush
+    uint32_t coalescedOffset{0}, monoCoalescedOffset{0};
     std::array<std::array<int8_t, 128>, 16> midi1CC{};
 
     using voiceManager_t = sst::voicemanager::VoiceManager<Config, Responder, MonoResponder>;
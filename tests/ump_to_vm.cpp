@@ -0,0 +1,173 @@
+/*
+ * sst-voicemanager - a header only library providing synth
+ * voice management in response to midi and clap event streams
+ * with support for a variety of play, trigger, and midi nodes
+ *
+ * Copyright 2023-2024, various authors, as described in the GitHub
+ * transaction log.
+ *
+ * sst-voicemanager is released under the MIT license, available
+ * as LICENSE.md in the root of this repository.
+ *
+ * All source in sst-voicemanager available at
+ * https://github.com/surge-synthesizer/sst-voicemanager
+ */
+
+#include "catch2.hpp"
+
+#include <vector>
+
+#include "sst/voicemanager/voicemanager.h"
+#include "sst/voicemanager/ump_to_voicemanager.h"
+#include "test_player.h"
+
+namespace svm = sst::voicemanager;
+
+namespace
+{
+// First word of a MIDI 2 channel voice packet
+uint32_t m2(uint32_t group, uint32_t status, uint32_t chan, uint32_t b1, uint32_t b2 = 0)
+{
+    return (0x4U << 28) | (group << 24) | (status << 20) | (chan << 16) | (b1 << 8) | b2;
+}
+
+void applyAll(TestPlayer<32>::voiceManager_t &vm, const std::vector<uint32_t> &w)
+{
+    REQUIRE(svm::applyUMPWords(vm, w) == w.size());
+}
+} // namespace
+
+TEST_CASE("UMP MIDI 2 Notes")
+{
+    SECTION("Full Resolution Velocity")
+    {
+        auto tp = TestPlayer<32>();
+        auto &vm = tp.voiceManager;
+
+        applyAll(vm, {m2(0, 0x9, 0, 60), 0x8000U << 16});
+        REQUIRE_VOICE_COUNTS(1, 1);
+        REQUIRE(tp.activeVoicesMatching([](auto &v)
+                                        { return v.velocity == 32768 / 65535.f; }) == 1);
+
+        applyAll(vm, {m2(0, 0x8, 0, 60), 0});
+        REQUIRE_VOICE_COUNTS(1, 0);
+    }
+
+    SECTION("Velocity Zero Is Still A Note On")
+    {
+        auto tp = TestPlayer<32>();
+        auto &vm = tp.voiceManager;
+
+        applyAll(vm, {m2(0, 0x9, 0, 60), 0});
+        REQUIRE_VOICE_COUNTS(1, 1);
+    }
+
+    SECTION("Pitch Attribute Becomes Retune")
+    {
+        auto tp = TestPlayer<32>();
+        auto &vm = tp.voiceManager;
+
+        // Key 60 sounding at 60.5 semitones, as 7.9 fixed point
+        applyAll(vm, {m2(0, 0x9, 0, 60, 3), (0xFFFFU << 16) | (60 * 512 + 256)});
+        REQUIRE(tp.activeVoicesMatching([](auto &v) { return v.retune == 0.5f; }) == 1);
+    }
+
+    SECTION("Group Is Port")
+    {
+        auto tp = TestPlayer<32>();
+        auto &vm = tp.voiceManager;
+
+        applyAll(vm, {m2(2, 0x9, 5, 64), 0xFFFFU << 16});
+        REQUIRE(tp.activeVoicesMatching([](auto &v)
+                                        { return v.port() == 2 && v.channel() == 5; }) == 1);
+    }
+}
+
+TEST_CASE("UMP Per Note Messages Are Note Expressions")
+{
+    auto tp = TestPlayer<32>();
+    auto &vm = tp.voiceManager;
+
+    applyAll(vm, {m2(0, 0x9, 0, 60), 0xFFFFU << 16, m2(0, 0x9, 0, 62), 0xFFFFU << 16});
+    applyAll(vm, {m2(0, 0x6, 0, 62), 0xC0000000U, m2(0, 0x0, 0, 62, 74), 0xFFFFFFFFU,
+                  m2(0, 0x1, 0, 60, 9), 0});
+
+    auto expr = [&tp](int16_t key, int32_t id) -> double
+    {
+        for (const auto &v : tp.voiceStorage)
+            if (v.state == TestPlayer<32>::Voice::ACTIVE && v.key() == key)
+            {
+                auto it = v.noteExpressionCache.find(id);
+                return it == v.noteExpressionCache.end() ? -100 : it->second;
+            }
+        return -200;
+    };
+    REQUIRE(expr(62, svm::umpPerNotePitchBendExpression) == 0.5);
+    REQUIRE(expr(62, svm::umpRegisteredPerNoteControllerBase + 74) == 1.0);
+    REQUIRE(expr(60, svm::umpAssignablePerNoteControllerBase + 9) == 0.0);
+    REQUIRE(expr(60, svm::umpPerNotePitchBendExpression) == -100);
+
+    // Registered controller 3 (Pitch 7.25) must not land on a CLAP expression id such as
+    // CLAP_NOTE_EXPRESSION_VIBRATO (3)
+    applyAll(vm, {m2(0, 0x0, 0, 60, 3), 0xFFFFFFFFU});
+    REQUIRE(expr(60, 1024 + 3) == 1.0);
+    REQUIRE(expr(60, 3) == -100);
+}
+
+TEST_CASE("UMP Channel Messages")
+{
+    auto tp = TestPlayer<32>();
+    auto &vm = tp.voiceManager;
+
+    applyAll(vm, {m2(0, 0xB, 3, 7), 0x80000000U, m2(0, 0xE, 3, 0), 0xFFFFFFFFU,
+                  m2(0, 0xD, 3, 0), 0x40000000U});
+    REQUIRE(tp.midi1CC[3][7] == 64);
+    REQUIRE(tp.pitchBend[3] == 16383);
+    REQUIRE(tp.channelPressure[3] == 32);
+
+    // The sustain pedal arrives as a 32 bit controller but still holds notes
+    applyAll(vm, {m2(0, 0x9, 0, 60), 0xFFFFU << 16, m2(0, 0xB, 0, 64), 0xFFFFFFFFU,
+                  m2(0, 0x8, 0, 60), 0});
+    REQUIRE_VOICE_COUNTS(1, 1);
+    applyAll(vm, {m2(0, 0xB, 0, 64), 0});
+    REQUIRE_VOICE_COUNTS(1, 0);
+}
+
+TEST_CASE("UMP Stream Handling")
+{
+    SECTION("MIDI 1 Packets")
+    {
+        auto tp = TestPlayer<32>();
+        auto &vm = tp.voiceManager;
+
+        applyAll(vm, {0x20903C40U});
+        REQUIRE_VOICE_COUNTS(1, 1);
+        applyAll(vm, {0x20803C00U});
+        REQUIRE_VOICE_COUNTS(1, 0);
+    }
+
+    SECTION("Other Packets Are Skipped By Length")
+    {
+        auto tp = TestPlayer<32>();
+        auto &vm = tp.voiceManager;
+
+        // A timestamp, a four word data packet and a system message around one note on
+        applyAll(vm, {0x00200010U, 0x50000000U, 0x90909090U, 0x90909090U, 0x90909090U,
+                      m2(0, 0x9, 0, 60), 0xFFFFU << 16, 0x10F80000U});
+        REQUIRE_VOICE_COUNTS(1, 1);
+    }
+
+    SECTION("A Cut Off Packet Is Left For Next Time")
+    {
+        auto tp = TestPlayer<32>();
+        auto &vm = tp.voiceManager;
+
+        std::vector<uint32_t> w{m2(0, 0x9, 0, 60), 0xFFFFU << 16, m2(0, 0x9, 0, 62)};
+        REQUIRE(svm::applyUMPWords(vm, w) == 2);
+        REQUIRE_VOICE_COUNTS(1, 1);
+
+        w = {m2(0, 0x9, 0, 62), 0xFFFFU << 16};
+        REQUIRE(svm::applyUMPWords(vm, w) == 2);
+        REQUIRE_VOICE_COUNTS(2, 2);
+    }
+}
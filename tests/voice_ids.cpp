@@ -390,3 +390,105 @@ TEST_CASE("Voice ID in Mono Mode")
         REQUIRE_NO_VOICES;
     }
 }
+
+TEST_CASE("Voice ID Shared Across Voices")
+{
+    typedef TestPlayer<4, false> player_t;
+    typedef TestPlayer<4, false>::voiceManager_t vm_t;
+    typedef TestPlayer<4, false>::Voice vc_t;
+
+    SECTION("Retriggered Voices Keep Sharing An ID")
+    {
+        auto tp = player_t();
+        vm_t &vm = tp.voiceManager;
+        REQUIRE(vm.getVoiceCount() == 0);
+
+        INFO("Multi voice mode lets the same key and id sound twice");
+        vm.processNoteOnEvent(0, 0, 60, 742, 0.8, 0);
+        tp.processFor(2);
+        vm.processNoteOnEvent(0, 0, 60, 742, 0.8, 0);
+        vm.processNoteOnEvent(0, 0, 62, 8433, 0.8, 0);
+        REQUIRE_VOICE_COUNTS(3, 3);
+        REQUIRE_VOICE_MATCH_FN(2, [](const vc_t &v) { return v.voiceId == 742; });
+
+        vm.routePolyphonicParameterModulation(0, 0, 60, 742, 123, 0.4);
+        REQUIRE_VOICE_MATCH_FN(2, [](const vc_t &v)
+                               { return v.paramModulationCache.count(123) == 1; });
+        REQUIRE_VOICE_MATCH_FN(
+            2, [](const vc_t &v)
+            { return v.voiceId == 742 && v.paramModulationCache.at(123) == 0.4; });
+
+        vm.processNoteOffEvent(0, 0, 60, 742, 0.0);
+        REQUIRE_VOICE_COUNTS(3, 1);
+        REQUIRE_VOICE_MATCH_FN(1, [](const vc_t &v) { return v.isGated && v.voiceId == 8433; });
+
+        tp.processFor(10);
+        REQUIRE_VOICE_COUNTS(1, 1);
+        REQUIRE(tp.terminatedVoiceSet.count(742) == 1);
+
+        INFO("Nothing holds 742 any more so its modulation goes nowhere");
+        vm.routePolyphonicParameterModulation(0, 0, 60, 742, 124, 0.2);
+        REQUIRE_VOICE_MATCH_FN(0, [](const vc_t &v)
+                               { return v.paramModulationCache.count(124) == 1; });
+
+        vm.processNoteOffEvent(0, 0, 62, 8433, 0.0);
+        tp.processFor(10);
+        REQUIRE_NO_VOICES;
+    }
+
+    SECTION("Stealing Part Of A Shared ID")
+    {
+        auto tp = player_t();
+        vm_t &vm = tp.voiceManager;
+        REQUIRE(vm.getVoiceCount() == 0);
+
+        INFO("Retrigger 742 on more keys so three notes share the id");
+        vm.processNoteOnEvent(0, 0, 60, 742, 0.8, 0);
+        tp.processFor(2);
+        vm.processNoteOnEvent(0, 0, 64, 742, 0.8, 0);
+        tp.processFor(2);
+        vm.processNoteOnEvent(0, 0, 67, 742, 0.8, 0);
+        tp.processFor(2);
+        vm.processNoteOnEvent(0, 0, 62, 8433, 0.8, 0);
+        REQUIRE_VOICE_COUNTS(4, 4);
+        REQUIRE_VOICE_MATCH_FN(3, [](const vc_t &v) { return v.voiceId == 742; });
+
+        INFO("A fifth voice steals the oldest, so 742 loses its first voice");
+        tp.processFor(2);
+        vm.processNoteOnEvent(0, 0, 65, 1024, 0.8, 0);
+        REQUIRE_VOICE_COUNTS(4, 4);
+        REQUIRE_VOICE_MATCH_FN(2, [](const vc_t &v) { return v.voiceId == 742; });
+        REQUIRE_VOICE_MATCH_FN(0, [](const vc_t &v) { return v.key() == 60; });
+        REQUIRE_VOICE_MATCH_FN(1, [](const vc_t &v) { return v.voiceId == 1024; });
+
+        vm.routePolyphonicParameterModulation(0, 0, 60, 742, 123, 0.6);
+        REQUIRE_VOICE_MATCH_FN(2, [](const vc_t &v)
+                               { return v.paramModulationCache.count(123) == 1; });
+        REQUIRE_VOICE_MATCH_FN(
+            2, [](const vc_t &v)
+            { return v.voiceId == 742 && v.paramModulationCache.at(123) == 0.6; });
+
+        INFO("The stealing voice took the slot but not the old id");
+        vm.routePolyphonicParameterModulation(0, 0, 65, 1024, 124, 0.3);
+        REQUIRE_VOICE_MATCH_FN(1, [](const vc_t &v)
+                               { return v.paramModulationCache.count(124) == 1; });
+        REQUIRE_VOICE_MATCH_FN(1, [](const vc_t &v)
+                               { return v.voiceId == 1024 && v.paramModulationCache.count(124); });
+
+        INFO("Note off by key only releases the voice on that key");
+        vm.processNoteOffEvent(0, 0, 64, 742, 0.0);
+        REQUIRE_VOICE_COUNTS(4, 3);
+        REQUIRE_VOICE_MATCH_FN(1, [](const vc_t &v) { return v.voiceId == 742 && !v.isGated; });
+        vm.processNoteOffEvent(0, 0, 67, 742, 0.0);
+        REQUIRE_VOICE_COUNTS(4, 2);
+        REQUIRE_VOICE_MATCH_FN(2, [](const vc_t &v) { return v.voiceId == 742 && !v.isGated; });
+        tp.processFor(10);
+        REQUIRE_VOICE_COUNTS(2, 2);
+        REQUIRE_VOICE_MATCH_FN(0, [](const vc_t &v) { return v.voiceId == 742; });
+
+        vm.processNoteOffEvent(0, 0, 62, 8433, 0.0);
+        vm.processNoteOffEvent(0, 0, 65, 1024, 0.0);
+        tp.processFor(10);
+        REQUIRE_NO_VOICES;
+    }
+}
@@ -0,0 +1,115 @@
+/*
+ * sst-voicemanager - a header only library providing synth
+ * voice management in response to midi and clap event streams
+ * with support for a variety of play, trigger, and midi nodes
+ *
+ * Copyright 2023-2024, various authors, as described in the GitHub
+ * transaction log.
+ *
+ * sst-voicemanager is released under the MIT license, available
+ * as LICENSE.md in the root of this repository.
+ *
+ * All source in sst-voicemanager available at
+ * https://github.com/surge-synthesizer/sst-voicemanager
+ */
+
+#include "catch2.hpp"
+
+#include <random>
+#include <vector>
+
+#include "sst/voicemanager/voicemanager.h"
+#include "test_player.h"
+
+namespace svd = sst::voicemanager::detail;
+
+template <size_t N> void checkLaneMatchAgainstScalar(uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    auto val = [&rng]() { return static_cast<int16_t>(static_cast<int>(rng() % 4) - 1); };
+
+    std::array<int16_t, N> port, channel, key;
+    for (auto trial = 0; trial < 200; ++trial)
+    {
+        for (size_t i = 0; i < N; ++i)
+        {
+            port[i] = val();
+            channel[i] = val();
+            key[i] = val();
+        }
+        auto pt = val(), ch = val(), k = val();
+
+        auto mask = svd::matchVoiceLanes(port, channel, key, pt, ch, k);
+
+        std::vector<int32_t> expected, got;
+        for (size_t i = 0; i < N; ++i)
+        {
+            auto bit = (mask[i >> 6] >> (i & 63)) & 1;
+            auto m = svd::laneMatches(port[i], pt) && svd::laneMatches(channel[i], ch) &&
+                     svd::laneMatches(key[i], k);
+            REQUIRE(bit == (m ? 1U : 0U));
+            if (m)
+                expected.push_back(static_cast<int32_t>(i));
+        }
+        for (auto idx : svd::SetBits{mask})
+            got.push_back(idx);
+        REQUIRE(got == expected);
+    }
+}
+
+TEST_CASE("Voice Lane Matching Agrees With Scalar")
+{
+    SECTION("Under One Vector") { checkLaneMatchAgainstScalar<5>(1); }
+    SECTION("Whole Vectors") { checkLaneMatchAgainstScalar<64>(2); }
+    SECTION("Across Words With A Tail") { checkLaneMatchAgainstScalar<133>(3); }
+}
+
+TEST_CASE("Set Bits Visits Each Slot Once In Order")
+{
+    svd::SlotMask<200> mask{};
+    std::vector<int32_t> expected{0, 63, 64, 130, 199};
+    for (auto i : expected)
+        mask[i >> 6] |= 1ULL << (i & 63);
+
+    std::vector<int32_t> got;
+    for (auto idx : svd::SetBits{mask})
+        got.push_back(idx);
+    REQUIRE(got == expected);
+
+    svd::SlotMask<200> empty{};
+    REQUIRE(!(svd::SetBits{empty}.begin() != svd::SetBits{empty}.end()));
+}
+
+TEST_CASE("MPE Routing Reaches Only The Matching Channel")
+{
+    // Enough voices that the match spans more than one lane word
+    TestPlayer<96> tp;
+    auto &vm = tp.voiceManager;
+    vm.dialect = TestPlayer<96>::voiceManager_t::MIDI1Dialect::MIDI1_MPE;
+
+    for (int ch = 1; ch < 16; ++ch)
+        for (int k = 0; k < 6; ++k)
+            vm.processNoteOnEvent(0, ch, 40 + k, -1, 0.8, 0.0);
+    REQUIRE_VOICE_COUNTS(90, 90);
+
+    vm.routeMIDI1CC(0, 14, 74, 33);
+    vm.routeChannelPressure(0, 14, 71);
+    vm.routePolyphonicAftertouch(0, 14, 43, 55);
+    tp.processFor(1);
+
+    int timbre{0}, pressure{0}, pat{0};
+    for (const auto &v : tp.voiceStorage)
+    {
+        if (v.state != TestPlayer<96>::Voice::ACTIVE)
+            continue;
+        auto onCh = v.channel() == 14;
+        REQUIRE((v.mpeTimbre == 33) == onCh);
+        REQUIRE((v.mpePressure == 71) == onCh);
+        timbre += v.mpeTimbre == 33;
+        pressure += v.mpePressure == 71;
+        pat += v.polyATValue == 55;
+    }
+    REQUIRE(timbre == 6);
+    REQUIRE(pressure == 6);
+    REQUIRE(pat == 1);
+}